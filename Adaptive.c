@@ -0,0 +1,226 @@
+// Contention-adaptive lock in the spirit of reactive locks (Beng-Hong Lim and Anant Agarwal, Reactive
+// Synchronization Algorithms for Multiprocessors, ASPLOS VI, 1994), which switches at runtime between a low-contention
+// and a high-contention protocol:
+//   default   test-and-test-and-set spin lock <-> MCS queue lock
+//   SOFT      Lamport fast algorithm <-> Tree.c binary tournament (TaubenfeldBuhr), no atomic instructions
+//
+// A thread reads the current mode, acquires that protocol, and rechecks the mode; if the mode changed while it waited,
+// it releases the stale protocol and retries.  Only a thread in the critical section changes mode: it acquires the
+// other protocol while still holding the current one, publishes the new mode, and releases the old protocol, so any
+// thread subsequently winning the old protocol sees the new mode and backs out.  The critical-section holder maintains
+// a saturating contention score (no extra shared writes outside the critical section), switching to the high protocol
+// when it reaches ADAPT and back to the low protocol when it reaches 0.  With CNT, counters switches, retries and high
+// count mode switches, stale-protocol retries and entries in high mode.
+
+#include <stdbool.h>
+
+#ifndef ADAPT
+#define ADAPT 16										// contention score to switch to high mode
+#endif // ! ADAPT
+
+enum { Low, High };
+
+#define COUNTERS( C ) C( switches ) C( retries ) C( high )
+DeclareCounters( COUNTERS )
+
+#ifdef SOFT
+
+#define inv( c ) ( (c) ^ 1 )
+
+#include "Tree.c"
+
+static volatile TYPE *b CALIGN;
+static volatile TYPE x CALIGN, y CALIGN;
+
+#define await( E ) while ( ! (E) ) Pause()
+
+static inline bool lowEntry( TYPE id ) {				// Lamport fast algorithm, true => contended
+	bool contended = false;
+  start: b[id] = true;
+	x = id;
+	Fence();											// force store before more loads
+	if ( FASTPATH( y != N ) ) {
+		contended = true;
+		b[id] = false;
+		Fence();										// force store before more loads
+		await( y == N );
+		goto start;
+	} // if
+	y = id;
+	Fence();											// force store before more loads
+	if ( FASTPATH( x != id ) ) {
+		contended = true;
+		b[id] = false;
+		Fence();										// force store before more loads
+		for ( int j = 0; j < N; j += 1 )
+			await( ! b[j] );
+		if ( FASTPATH( y != id ) ) goto start;
+	} // if
+	return contended;
+} // lowEntry
+
+static inline void lowExit( TYPE id ) {
+	y = N;
+	b[id] = false;
+} // lowExit
+
+static inline bool highEntry( TYPE id ) {				// tournament, true => opponent at root
+	tree_entry( id );
+	if ( heights[id] == 0 ) return false;
+	const Path *root = &paths[id][heights[id] - 1];
+	return root->ns->Q[inv( root->es )] != 0;
+} // highEntry
+
+static inline void highExit( TYPE id ) {
+	tree_exit( id );
+} // highExit
+
+#else
+
+typedef struct mcs_node MCS_node;
+typedef struct CALIGN mcs_node {
+	MCS_node *volatile next;
+	volatile TYPE spin;
+} *MCS_lock;
+
+static volatile TYPE lock
+#if defined( __i386 ) || defined( __x86_64 )
+	__attribute__(( aligned (128) ));					// Intel recommendation
+#else
+	CALIGN;
+#endif
+static MCS_lock mcs CALIGN;
+static MCS_node *nodes CALIGN;							// queue node for each thread
+
+static inline bool lowEntry( TYPE id __attribute__(( unused )) ) { // spin lock, true => lock busy on arrival
+	if ( FASTPATH( lock == 0 && __sync_lock_test_and_set( &lock, 1 ) == 0 ) ) return false;
+	while ( lock != 0 || __sync_lock_test_and_set( &lock, 1 ) != 0 ) Pause();
+	return true;
+} // lowEntry
+
+static inline void lowExit( TYPE id __attribute__(( unused )) ) {
+	__sync_lock_release( &lock );
+} // lowExit
+
+static inline bool highEntry( TYPE id ) {				// MCS, true => predecessor or successor queued
+	MCS_node *node = &nodes[id], *pred;
+	node->next = NULL;
+	pred = __sync_lock_test_and_set( &mcs, node );		// fetch-and-store
+	if ( FASTPATH( pred != NULL ) ) {					// someone on list ?
+		node->spin = 1;									// mark as waiting
+		pred->next = node;								// add to list of waiting threads
+		while ( node->spin == 1 ) Pause();				// busy wait on my spin variable
+		return true;
+	} // if
+	return node->next != NULL;
+} // highEntry
+
+static inline void highExit( TYPE id ) {
+	MCS_node *node = &nodes[id];
+	if ( node->next == NULL ) {							// no one waiting ?
+	  if ( __sync_bool_compare_and_swap( &mcs, node, NULL ) ) return; // not changed since last looked ?
+		while ( node->next == NULL ) Pause();			// busy wait until my node is modified
+	} // if
+	node->next->spin = 0;								// stop their busy wait
+} // highExit
+
+#endif // SOFT
+
+static volatile TYPE mode CALIGN;						// protocol guarding the critical section
+static TYPE score CALIGN;								// contention score, only accessed in critical section
+static TYPE PAD CALIGN __attribute__(( unused ));		// protect further false sharing
+
+static inline bool modeEntry( TYPE m, TYPE id ) {
+	return m == Low ? lowEntry( id ) : highEntry( id );
+} // modeEntry
+
+static inline void modeExit( TYPE m, TYPE id ) {
+	if ( m == Low ) lowExit( id ); else highExit( id );
+} // modeExit
+
+static void *Worker( void *arg ) {
+	TYPE id = (size_t)arg;
+	uint64_t entry;
+#ifdef FAST
+	unsigned int cnt = 0, oid = id;
+#endif // FAST
+
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		entry = 0;
+		while ( stop == 0 ) {
+			TYPE m;
+			bool contended;
+			for ( ;; ) {								// entry protocol
+				m = mode;
+				contended = modeEntry( m, id );
+			  if ( FASTPATH( mode == m ) ) break;		// protocol still current ?
+				modeExit( m, id );						// stale, back out
+				Count( retries );
+			} // for
+
+			CriticalSection( id );
+
+			if ( contended ) {							// adapt, holding current protocol
+				if ( score < ADAPT ) score += 1;
+			} else {
+				if ( score > 0 ) score -= 1;
+			} // if
+			if ( FASTPATH( (m == Low && score == ADAPT) || (m == High && score == 0) ) ) {
+				TYPE other = m ^ 1;
+				modeEntry( other, id );					// stale holders of other protocol back out
+				mode = other;
+				Fence();								// force store before more loads
+				modeExit( m, id );						// waiters on old protocol see new mode
+				m = other;
+				Count( switches );
+			} // if
+			if ( m == High ) Count( high );
+			modeExit( m, id );							// exit protocol
+#ifdef FAST
+			id = startpoint( cnt );						// different starting point each experiment
+			cnt = cycleUp( cnt, NoStartPoints );
+#endif // FAST
+			entry += 1;
+			Passage( id );
+		} // while
+#ifdef FAST
+		id = oid;
+#endif // FAST
+		entries[r][id] = entry;
+		__sync_fetch_and_add( &Arrived, 1 );
+		while ( stop != 0 ) Pause();
+		__sync_fetch_and_add( &Arrived, -1 );
+	} // for
+	return NULL;
+} // Worker
+
+void __attribute__((noinline)) ctor() {
+#ifdef SOFT
+	b = Allocator( sizeof(typeof(b[0])) * N );
+	for ( int i = 0; i < N; i += 1 ) {					// initialize shared data
+		b[i] = false;
+	} // for
+	y = N;
+	tree_ctor( 2 );										// binary tree of 2-thread nodes
+#else
+	lock = 0;
+	mcs = NULL;
+	nodes = Allocator( sizeof(typeof(nodes[0])) * N );
+#endif // SOFT
+	mode = Low;
+	score = 0;
+} // ctor
+
+void __attribute__((noinline)) dtor() {
+#ifdef SOFT
+	tree_dtor();
+	free( (void *)b );
+#else
+	free( nodes );
+#endif // SOFT
+} // dtor
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-command: "gcc -Wall -std=gnu11 -O3 -DNDEBUG -fno-reorder-functions -DPIN -DAlgorithm=Adaptive Harness.c -lpthread -lm" //
+// End: //
@@ -2,29 +2,49 @@
 //#define inv( c ) (! (c))
 //#define inv( c ) ((c) ^ 1)
 
-typedef struct CALIGN {
+#ifndef BINARY_C										// included once, e.g., by both Tree.c and FastPath.c
+#define BINARY_C
+
+// Each 2-thread algorithm is a separate prologue/epilogue pair so a tree can mix algorithms (MIXED). Otherwise,
+// binary_prologue/binary_epilogue select one algorithm at compile time, Peterson by default.
+
+typedef struct
+#ifndef PACKTOKEN										// unpadded tokens for packed tree layouts
+CALIGN
+#endif // ! PACKTOKEN
+{
 	TYPE Q[2];
+#if ! defined( KESSELS2 ) || defined( MIXED )
 #if defined( __sparc ) && defined( TB )
 	int /* gcc on SPARC has an issue with unsigned affecting performance */
 #else
 	TYPE
 #endif // TB
-#if defined( KESSELS2 )
-	R[2];
-#else
 	R;
-#endif // KESSELS
+#endif // ! KESSELS2 || MIXED
+#if defined( KESSELS2 ) || defined( MIXED )
+	TYPE K[2];											// Kessels per-thread turn bits
+#endif // KESSELS2 || MIXED
 } Token;
 
-static inline void binary_prologue( TYPE c, volatile Token *t ) {
+#if defined( KESSELS2 ) || defined( MIXED )
+static inline void kessels2_prologue( TYPE c, volatile Token *t ) {
 	int other = inv( c );								// int is better than TYPE
-#if defined( KESSELS2 )
 	t->Q[c] = 1;
 	Fence();											// force store before more loads
-	t->R[c] = t->R[other] ^ c ;
+	t->K[c] = t->K[other] ^ c ;
 	Fence();											// force store before more loads
-	while ( t->Q[other] == 1 && t->R[c] == (t->R[other] ^ c) ) Pause() ;
-#elif defined( DEKKERORIG )
+	while ( t->Q[other] == 1 && t->K[c] == (t->K[other] ^ c) ) Pause() ;
+} // kessels2_prologue
+
+static inline void kessels2_epilogue( TYPE c, volatile Token *t ) {
+	t->Q[c] = 0;
+} // kessels2_epilogue
+#endif // KESSELS2 || MIXED
+
+#if ! defined( KESSELS2 ) || defined( MIXED )
+static inline void dekkerorig_prologue( TYPE c, volatile Token *t ) {
+	int other = inv( c );								// int is better than TYPE
   A1: t->Q[c] = 1;
 	Fence();											// force store before more loads
   L1: if ( FASTPATH( t->Q[other] ) ) {
@@ -33,7 +53,10 @@ static inline void binary_prologue( TYPE c, volatile Token *t ) {
 	  B1: if ( t->R == c ) { Pause(); goto B1; }		// low priority busy wait
 		goto A1;
 	} // if
-#elif defined( DEKKERA )
+} // dekkerorig_prologue
+
+static inline void dekkera_prologue( TYPE c, volatile Token *t ) {
+	int other = inv( c );								// int is better than TYPE
 	for ( ;; ) {
 		t->Q[c] = 1;
 		Fence();										// force store before more loads
@@ -43,7 +66,10 @@ static inline void binary_prologue( TYPE c, volatile Token *t ) {
 			while ( t->R == c ) Pause();				// low priority busy wait
 		} // if
 	} // for
-#elif defined( DEKKERB )
+} // dekkera_prologue
+
+static inline void dekkerb_prologue( TYPE c, volatile Token *t ) {
+	int other = inv( c );								// int is better than TYPE
 	for ( ;; ) {
 		t->Q[c] = 1;
 		Fence();										// force store before more loads
@@ -55,7 +81,10 @@ static inline void binary_prologue( TYPE c, volatile Token *t ) {
 		t->Q[c] = 0;
 		while ( t->R == c ) Pause();					// low priority busy wait
 	} // for
-#elif defined( DORAN )
+} // dekkerb_prologue
+
+static inline void doran_prologue( TYPE c, volatile Token *t ) {
+	int other = inv( c );								// int is better than TYPE
 	t->Q[c] = 1;
 	Fence();											// force store before more loads
 	if ( FASTPATH( t->Q[other] ) ) {
@@ -67,7 +96,15 @@ static inline void binary_prologue( TYPE c, volatile Token *t ) {
 		} // if
 		while ( t->Q[other] ) Pause();					// low priority busy wait
 	} // if
-#elif defined( DEKKERRW )
+} // doran_prologue
+
+static inline void dekker_epilogue( TYPE c, volatile Token *t ) { // DekkerOrig, DekkerA, DekkerB, Doran
+	t->R = c;
+	t->Q[c] = 0;
+} // dekker_epilogue
+
+static inline void dekkerrw_prologue( TYPE c, volatile Token *t ) {
+	int other = inv( c );								// int is better than TYPE
 	for ( ;; ) {
 		t->Q[c] = 1;
 		Fence();										// force store before more loads
@@ -79,39 +116,78 @@ static inline void binary_prologue( TYPE c, volatile Token *t ) {
 		t->Q[c] = 0;
 		while ( t->Q[other] && t->R == c ) Pause();
 	} // for
-#elif defined( TSAY )
+} // dekkerrw_prologue
+
+static inline void dekkerrw_epilogue( TYPE c, volatile Token *t ) {
+	if ( t->R != c ) {
+		t->R = c;
+	} // if
+	t->Q[c] = 0;
+} // dekkerrw_epilogue
+
+static inline void tsay_prologue( TYPE c, volatile Token *t ) {
+	int other = inv( c );								// int is better than TYPE
 	t->Q[c] = 1;
 	t->R = c;											// RACE
 	Fence();											// force store before more loads
 	if ( FASTPATH( t->Q[other] ) )
 		while ( t->R == c ) Pause();					// busy wait
-#else // Peterson (default)
-	t->Q[c] = 1;
-	t->R = c;											// RACE
+} // tsay_prologue
+
+static inline void tsay_epilogue( TYPE c, volatile Token *t ) {
+	t->Q[c] = 0;
+	t->R = c;
+} // tsay_epilogue
+
+static inline void peterson_prologue( TYPE c, volatile Token *t ) {
+	int other = inv( c );								// int is better than TYPE
+	ST( t->Q[c], 1 );
+	ST( t->R, c );										// RACE
 	Fence();											// force store before more loads
-	while ( t->Q[other] && t->R == c ) Pause();			// busy wait
+	while ( LD( t->Q[other] ) && LD( t->R ) == c ) Pause(); // busy wait
+} // peterson_prologue
+
+static inline void peterson_epilogue( TYPE c, volatile Token *t ) {
+	ST( t->Q[c], 0 );
+} // peterson_epilogue
+#endif // ! KESSELS2 || MIXED
+
+static inline void binary_prologue( TYPE c, volatile Token *t ) {
+#if defined( KESSELS2 )
+	kessels2_prologue( c, t );
+#elif defined( DEKKERORIG )
+	dekkerorig_prologue( c, t );
+#elif defined( DEKKERA )
+	dekkera_prologue( c, t );
+#elif defined( DEKKERB )
+	dekkerb_prologue( c, t );
+#elif defined( DORAN )
+	doran_prologue( c, t );
+#elif defined( DEKKERRW )
+	dekkerrw_prologue( c, t );
+#elif defined( TSAY )
+	tsay_prologue( c, t );
+#else // Peterson (default)
+	peterson_prologue( c, t );
 #endif
 } // binary_prologue
 
 static inline void binary_epilogue( TYPE c, volatile Token *t ) {
 #if defined( KESSELS2 )
-	t->Q[c] = 0;
+	kessels2_epilogue( c, t );
 #elif defined( DEKKERORIG ) || defined( DEKKERA ) || defined( DEKKERB ) || defined( DORAN )
-	t->R = c;
-	t->Q[c] = 0;
+	dekker_epilogue( c, t );
 #elif defined( DEKKERRW )
-	if ( t->R != c ) {
-		t->R = c;
-	} // if
-	t->Q[c] = 0;
+	dekkerrw_epilogue( c, t );
 #elif defined( TSAY )
-	t->Q[c] = 0;
-	t->R = c;
+	tsay_epilogue( c, t );
 #else // Peterson (default)
-	t->Q[c] = 0;
+	peterson_epilogue( c, t );
 #endif
 } // binary_epilogue
 
+#endif // BINARY_C
+
 // Local Variables: //
 // tab-width: 4 //
 // End: //
@@ -44,6 +44,7 @@ static void *Worker( void *arg ) {
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -3,6 +3,10 @@
 
 enum Intent { DontWantIn, WantIn };
 
+// With CNT, l0 counts restarts at L0 (lower thread intent before or after declaring intent) and l1 rescans at L1.
+#define COUNTERS( C ) C( l0 ) C( l1 )
+DeclareCounters( COUNTERS )
+
 static volatile TYPE *intents CALIGN;					// shared
 
 static void *Worker( void *arg ) {
@@ -18,13 +22,13 @@ static void *Worker( void *arg ) {
 		  L0: intents[id] = DontWantIn;					// entry protocol
 			Fence();									// force store before more loads
 			for ( int j = 0; j < id; j += 1 )
-				if ( intents[j] == WantIn ) { Pause(); goto L0; }
+				if ( intents[j] == WantIn ) { Count( l0 ); Pause(); goto L0; }
 			intents[id] = WantIn;
 			Fence();									// force store before more loads
 			for ( int j = 0; j < id; j += 1 )
-				if ( intents[j] == WantIn ) goto L0;
+				if ( intents[j] == WantIn ) { Count( l0 ); goto L0; }
 		  L1: for ( int j = id + 1; j < N; j += 1 )
-				if ( intents[j] == WantIn ) { Pause(); goto L1; }
+				if ( intents[j] == WantIn ) { Count( l1 ); Pause(); goto L1; }
 			CriticalSection( id );						// critical section
 			intents[id] = DontWantIn;					// exit protocol
 #ifdef FAST
@@ -32,6 +36,7 @@ static void *Worker( void *arg ) {
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -1,3 +1,6 @@
+// No mutual exclusion: every thread stores to one shared word, the cost of communication among all threads.  The
+// per-CPU-pair cost of moving a cache line is measured by tools/CoreMatrix.cc.
+
 static volatile TYPE turn CALIGN;
 
 static void *Worker( void *arg ) {
@@ -10,6 +13,7 @@ static void *Worker( void *arg ) {
 			turn = id;									// perturb cache
 			Fence();									// force store before more loads
 			entry += 1;
+			Passage( id );
 		} // while
 		entries[r][id] = entry;
 		__sync_fetch_and_add( &Arrived, 1 );
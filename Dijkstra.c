@@ -24,7 +24,7 @@ static void *Worker( void *arg ) {
 			Fence();									// force store before more loads
 			for ( int j = 1; j <= N; j += 1 )
 				if ( j != id && c[j] == 0 ) goto L;
-			CriticalSection( id );
+			CriticalSection( id - 1 );					// adjust for id + 1
 			b[id] = c[id] = 1;							// exit protocol
 			turn = 0;
 #ifdef FAST
@@ -32,6 +32,7 @@ static void *Worker( void *arg ) {
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id - 1 );							// adjust for id + 1
 		} // while
 #ifdef FAST
 		id = oid;
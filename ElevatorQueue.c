@@ -10,17 +10,17 @@ typedef struct CALIGN {
 } Queue;
 
 static inline bool QnotEmpty( volatile Queue *queue ) {
-	return queue->front != queue->rear;
+	return LD( queue->front ) != LD( queue->rear );
 } // QnotEmpty
 
 static inline void Qenqueue( volatile Queue *queue, QElem_t element ) {
-	queue->elements[queue->rear] = element;
-	queue->rear = cycleUp( queue->rear, N );
+	ST( queue->elements[LD( queue->rear )], element );
+	ST( queue->rear, cycleUp( LD( queue->rear ), N ) );
 } // Qenqueue
 
 static inline QElem_t Qdequeue( volatile Queue *queue ) {
-	QElem_t element = queue->elements[queue->front];
-	queue->front = cycleUp( queue->front, N );
+	QElem_t element = LD( queue->elements[LD( queue->front )] );
+	ST( queue->front, cycleUp( LD( queue->front ), N ) );
 	return element;
 } // Qdequeue
 
@@ -63,49 +63,49 @@ static TYPE PAD CALIGN __attribute__(( unused ));		// protect further false shar
 
 #ifdef CAS
 
-#define WCas( x ) __sync_bool_compare_and_swap( &(fast), false, true )
+#define WCas( x ) __sync_bool_compare_and_swap( RMW( fast ), false, true )
 
 #elif defined( WCasBL )
 
 static inline bool WCas( TYPE id ) {					// based on Burns-Lamport algorithm
-	b[id] = true;
+	ST( b[id], true );
 	Fence();											// force store before more loads
 	for ( typeof(id) thr = 0; thr < id; thr += 1 ) {
-		if ( FASTPATH( b[thr] ) ) {
-			b[id] = false;
+		if ( FASTPATH( LD( b[thr] ) ) ) {
+			ST( b[id], false );
 			return false ;
 		} // if
 	} // for
 	for ( typeof(id) thr = id + 1; thr < N; thr += 1 ) {
-		await( ! b[thr] );
+		await( ! LD( b[thr] ) );
 	} // for
-	bool leader = ((! fast) ? fast = true : false);
-	b[id] = false;
+	bool leader = ((! LD( fast )) ? (ST( fast, true )) : false);
+	ST( b[id], false );
 	return leader;
 } // WCas
 
 #elif defined( WCasLF )
 
 static inline bool WCas( TYPE id ) {					// based on Lamport-Fast algorithm
-	b[id] = true;
-	x = id;
+	ST( b[id], true );
+	ST( x, id );
 	Fence();											// force store before more loads
-	if ( FASTPATH( y != N ) ) {
-		b[id] = false;
+	if ( FASTPATH( LD( y ) != N ) ) {
+		ST( b[id], false );
 		return false;
 	} // if
-	y = id;
+	ST( y, id );
 	Fence();											// force store before more loads
-	if ( FASTPATH( x != id ) ) {
-		b[id] = false;
+	if ( FASTPATH( LD( x ) != id ) ) {
+		ST( b[id], false );
 		Fence();										// force store before more loads
 		for ( int j = 0; j < N; j += 1 )
-			await( ! b[j] );
-		if ( FASTPATH( y != id ) ) return false;
+			await( ! LD( b[j] ) );
+		if ( FASTPATH( LD( y ) != id ) ) return false;
 	} // if
-	bool leader = ((! fast) ? fast = true : false);
-	y = N;
-	b[id] = false;
+	bool leader = ((! LD( fast )) ? (ST( fast, true )) : false);
+	ST( y, N );
+	ST( b[id], false );
 	return leader;
 } // WCas
 
@@ -132,54 +132,57 @@ static void *Worker( void *arg ) {
 	for ( int r = 0; r < RUNS; r += 1 ) {
 		entry = 0;
 		while ( stop == 0 ) {
-			*applyId = true;							// entry protocol
+			ST( *applyId, true );						// entry protocol
 			// loop goes from parent of leaf to child of root
 			for ( unsigned int j = (n >> 1); j > 1; j >>= 1 )
-				val[j] = id;
+				ST( val[j], id );
+			Delay( DelayDoorway );						// preempted while applying
+			DoorwayEnd();
 			if ( FASTPATH( WCas( id ) ) ) {				// true => leader
 #ifndef CAS
 				Fence();								// force store before more loads
 #endif // ! CAS
 
 #ifdef FLAG
-				await( *flagId || *flagN );
-				*flagN = false;
+				await( LD( *flagId ) || LD( *flagN ) );
+				ST( *flagN, false );
 #else
-				await( first == id || first == N );
-				first = id;
+				await( LD( first ) == id || LD( first ) == N );
+				ST( first, id );
 #endif // FLAG
-				fast = false;
+				ST( fast, false );
 			} else {
+				Delay( DelayWaiter );					// preempted while queued
 #ifdef FLAG
-				await( *flagId );
+				await( LD( *flagId ) );
 #else
-				await( first == id );
+				await( LD( first ) == id );
 #endif // FLAG
 			} // if
 #ifdef FLAG
-			*flagId = false;
+			ST( *flagId, false );
 #endif // FLAG
-			*applyId = false;
+			ST( *applyId, false );
 
 			CriticalSection( id );
 
 			// loop goes from child of root to leaf and inspects siblings
 			for ( int j = dep - 1; j >= 0; j -= 1 ) {	// must be "signed"
-				typeof(val[0]) k = val[(n >> j) ^ 1];
-				if ( FASTPATH( tstate[k].apply ) ) {
-					tstate[k].apply = false;
+				typeof(val[0]) k = LD( val[(n >> j) ^ 1] );
+				if ( FASTPATH( LD( tstate[k].apply ) ) ) {
+					ST( tstate[k].apply, false );
 					Qenqueue( &queue, k );
 				} // if
 			} // for
 			if ( FASTPATH( QnotEmpty( &queue ) ) )
 #ifdef FLAG
-				tstate[Qdequeue( &queue )].flag = true;
+				ST( tstate[Qdequeue( &queue )].flag, true );
 			else
-				*flagN = true;
+				ST( *flagN, true );
 #else
-				first = Qdequeue( &queue );
+				ST( first, Qdequeue( &queue ) );
 			else
-				first = N;
+				ST( first, N );
 #endif // FLAG
 
 #ifdef FAST
@@ -193,6 +196,7 @@ static void *Worker( void *arg ) {
 #endif // FLAG
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -41,7 +41,7 @@ static inline bool WCas( TYPE id ) {					// based on Burns-Lamport algorithm
 	for ( typeof(id) thr = id + 1; thr < N; thr += 1 ) {
 		await( ! b[thr] );
 	} // for
-	bool leader = ((! fast) ? fast = true : false);
+	bool leader = ((! fast) ? (fast = true) : false);
 	b[id] = false;
 	return leader;
 } // WCas
@@ -65,7 +65,7 @@ static inline bool WCas( TYPE id ) {					// based on Lamport-Fast algorithm
 			await( ! b[j] );
 		if ( FASTPATH( y != id ) ) return false;
 	} // if
-	bool leader = ((! fast) ? fast = true : false);
+	bool leader = ((! fast) ? (fast = true) : false);
 	y = N;
 	b[id] = false;
 	return leader;
@@ -143,6 +143,7 @@ static void *Worker( void *arg ) {
 #endif // FLAG
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
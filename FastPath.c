@@ -0,0 +1,133 @@
+// Leslie Lamport, A Fast Mutual Exclusion Algorithm, ACM Transactions on Computer Systems, 5(1), 1987, Fig. 2, p. 5
+// Wim H. Hesselink, Peter A. Buhr and David Dice, Fast Mutual Exclusion by the Triangle Algorithm
+//
+// Lamport's fast path placed in front of any N-thread algorithm, as Triangle does for its tournament tree.  An
+// uncontended thread wins the fast path (x, y, b[]) in O(1) and plays side 1 of a 2-thread arbiter; otherwise it takes
+// the slow path, i.e., the entry protocol of algorithm SLOW, and plays side 0 of the arbiter.  The slow algorithm must
+// provide entryProtocol( id ) and exitProtocol( id ), and its Worker is suppressed by NOWORKER, e.g.:
+//
+//   gcc ... -DAlgorithm=FastPath -DSLOW=LamportBakery Harness.c
+//
+// Slow paths: LamportBakery, Peterson, Lynch, MCS, TaubenfeldBuhr, ZhangdT (requires d-ary argument).  With CNT, counters
+// fast and slow count fast-path and slow-path entries.
+
+#include <stdbool.h>
+
+#define COUNTERS( C ) C( fast ) C( slow )
+DeclareCounters( COUNTERS )
+
+#ifndef SLOW
+	#error missing slow-path algorithm, e.g., -DSLOW=LamportBakery
+#endif // ! SLOW
+
+#define NOWORKER										// slow algorithm without Worker
+#define ctor slow_ctor
+#define dtor slow_dtor
+#include xstr(SLOW.c)								// include slow-path algorithm
+#undef dtor
+#undef ctor
+
+#ifndef inv
+#define inv( c ) ( (c) ^ 1 )
+#endif // ! inv
+#include "Binary.c"
+
+static volatile TYPE *fastb CALIGN;
+static volatile TYPE fastx CALIGN, fasty CALIGN;
+static volatile Token arbiter;							// fast (1) versus slow (0) winner
+static TYPE PAD2 CALIGN __attribute__(( unused ));		// protect further false sharing
+
+#define await( E ) while ( ! (E) ) Pause()
+
+static inline bool entryFast( TYPE id ) {				// true => won fast path
+	if ( FASTPATH( fasty != N ) ) return false;
+	fastb[id] = true;
+	fastx = id;
+	Fence();											// force store before more loads
+	if ( FASTPATH( fasty != N ) ) {
+		fastb[id] = false;
+		return false;
+	} // if
+	fasty = id;
+	Fence();											// force store before more loads
+	if ( FASTPATH( fastx != id ) ) {
+		fastb[id] = false;
+		Fence();										// force store before more loads
+		for ( int j = 0; fasty == id && j < N; j += 1 )
+			await( ! fastb[j] );
+		if ( FASTPATH( fasty != id ) ) return false;
+	} // if
+	return true;
+} // entryFast
+
+static inline void exitFast( TYPE id ) {
+	fasty = N;
+	fastb[id] = false;
+} // exitFast
+
+static void *Worker( void *arg ) {
+	TYPE id = (size_t)arg;
+	uint64_t entry;
+#ifdef FAST
+	unsigned int cnt = 0, oid = id;
+#endif // FAST
+
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		entry = 0;
+		while ( stop == 0 ) {
+			if ( entryFast( id ) ) {
+				Count( fast );
+				binary_prologue( 1, &arbiter );
+				CriticalSection( id );
+				binary_epilogue( 1, &arbiter );
+				exitFast( id );
+			} else {
+				Count( slow );
+				entryProtocol( id );
+				binary_prologue( 0, &arbiter );
+				CriticalSection( id );
+				binary_epilogue( 0, &arbiter );
+				exitProtocol( id );
+			} // if
+#ifdef FAST
+			id = startpoint( cnt );						// different starting point each experiment
+			cnt = cycleUp( cnt, NoStartPoints );
+#endif // FAST
+			entry += 1;
+			Passage( id );
+		} // while
+#ifdef FAST
+		id = oid;
+#endif // FAST
+		entries[r][id] = entry;
+		__sync_fetch_and_add( &Arrived, 1 );
+		while ( stop != 0 ) Pause();
+		__sync_fetch_and_add( &Arrived, -1 );
+	} // for
+	return NULL;
+} // Worker
+
+void __attribute__((noinline)) ctor() {
+	fastb = Allocator( sizeof(typeof(fastb[0])) * N );
+	for ( int i = 0; i < N; i += 1 ) {					// initialize shared data
+		fastb[i] = false;
+	} // for
+	fasty = N;
+	arbiter.Q[0] = arbiter.Q[1] = 0;
+#if defined( KESSELS2 )
+	arbiter.K[0] = arbiter.K[1] = 0;
+#else
+	arbiter.R = 0;
+#endif // KESSELS2
+	slow_ctor();										// slow-path allocation/initialization
+} // ctor
+
+void __attribute__((noinline)) dtor() {
+	slow_dtor();										// slow-path deallocation
+	free( (void *)fastb );
+} // dtor
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-command: "gcc -Wall -std=gnu11 -O3 -DNDEBUG -fno-reorder-functions -DPIN -DAlgorithm=FastPath -DSLOW=LamportBakery Harness.c -lpthread -lm" //
+// End: //
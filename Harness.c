@@ -6,22 +6,27 @@
 // entering the critical section, and atomically adds it subtotal entry-counter to a global total entry-counter. When
 // the driver unblocks after T seconds, it busy waits until all threads have noticed the stop flag and added their
 // subtotal to the global counter, which is then stored.  Five identical experiments are performed, each lasting T
-// seconds. The median value of the five results is printed.
+// seconds. The median value of the five results is printed, and with TOTALS, the five results follow on a "totals:"
+// line (as with DEBUG) for statistical comparison of result sets (tools/Compare.cc).
 
 #ifndef __cplusplus
 #define _GNU_SOURCE										// See feature_test_macros(7)
 #endif // __cplusplus
 #include <stdio.h>
 #include <stdlib.h>										// abort, exit, atoi, rand, qsort
+#include <string.h>										// strtok_r
 #include <math.h>										// sqrt
 #include <assert.h>
 #include <pthread.h>
 #include <errno.h>										// errno
 #include <stdint.h>										// uintptr_t, UINTPTR_MAX
 #include <sys/time.h>
-//#include <poll.h>										// poll
+#include <time.h>										// clock_gettime, nanosleep
+#include <poll.h>										// poll
 #include <malloc.h>										// memalign
 #include <unistd.h>										// getpid
+#include <sched.h>										// sched_getaffinity, sched_getcpu
+#include <semaphore.h>									// sem_post, sem_wait
 
 #if defined( __sparc )
 #define CACHE_ALIGN 4
@@ -125,6 +130,7 @@ typedef uintptr_t TYPE;									// atomically addressable word-size
 typedef volatile TYPE ATYPE;							// atomic shared data
 
 enum { RUNS = 5 };
+#define median(a) ((RUNS & 1) == 0 ? (a[RUNS/2-1] + a[RUNS/2]) / 2 : a[RUNS/2] )
 
 static inline TYPE cycleUp( TYPE v, TYPE n ) { return ( ((v) >= (n - 1)) ? 0 : (v + 1) ); }
 static inline TYPE cycleDown( TYPE v, TYPE n ) { return ( ((v) <= 0) ? (n - 1) : (v - 1) ); }
@@ -153,17 +159,668 @@ static inline int Clog2( int n ) {						// integer ceil( log2( n ) )
 
 //------------------------------------------------------------------------------
 
+#if defined( DELAY ) || defined( HANDOVER ) || defined( CYCLES ) || defined( BREAKDOWN ) || defined( TRACE ) || defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+static volatile int CurrRun CALIGN = 0;					// current run, advanced by driver while workers are stopped
+#endif // DELAY || HANDOVER || CYCLES || BREAKDOWN || TRACE || WORK || WINDOW || PRECISION
+
+static inline uint64_t nsec() {
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+} // nsec
+
+// Delay injection, modelling a descheduled thread.  DELAY is "where:permille:usec[:spin]": at injection point where, a
+// thread stalls with probability permille/1000 for usec microseconds, descheduled by nanosleep or, with spin, busy
+// waiting.  The points are:
+//   cs       inside the critical section, i.e., a preempted holder
+//   doorway  inside the entry protocol before the thread is ordered, for algorithms calling Delay( DelayDoorway )
+//   waiter   after the thread is ordered/queued but before it is granted, for algorithms calling Delay( DelayWaiter )
+// Algorithms with doorway points: LamportBakery, ElevatorQueue; with waiter points: LamportBakery, MCS, MCSTP,
+// ElevatorQueue.  Each passage (time between a thread's consecutive critical sections) is recorded in a log2
+// histogram, and the median run prints the stall count and passage percentiles.  Comparing with a run without DELAY
+// gives the throughput collapse.
+
+enum { DelayCS, DelayDoorway, DelayWaiter };
+
+#ifdef DELAY
+#ifdef FAST
+	#error DELAY requires multiple threads, not FAST
+#endif // FAST
+
+static int delayWhere CALIGN, delayPermille, delayUsec, delaySpin;
+static __thread unsigned int delaySeed;					// thread's random stream
+static __thread uint64_t delayStalls;					// thread's stalls in current run
+
+static void __attribute__((noinline)) Stall() {
+	delayStalls += 1;
+	if ( delaySpin ) {
+		uint64_t end = nsec() + delayUsec * 1000ull;
+		while ( nsec() < end ) Pause();
+	} else {
+		const struct timespec t = { delayUsec / 1000000, delayUsec % 1000000 * 1000 };
+		nanosleep( &t, NULL );
+	} // if
+} // Stall
+
+static inline void Delay( int where ) {
+	if ( where == delayWhere && (unsigned int)rand_r( &delaySeed ) % 1000 < (unsigned int)delayPermille ) Stall();
+} // Delay
+#else
+#define Delay( where )
+#endif // DELAY
+
+//------------------------------------------------------------------------------
+
+// Timestamps and log-linear latency histograms, with 8 sub-buckets per power of 2 (within 12.5%).
+
+#if defined( HANDOVER ) || defined( CYCLES ) || defined( BREAKDOWN ) || defined( TRACE )
+enum { SubBuckets = 8, LatencyBuckets = 64 * SubBuckets };
+typedef struct {
+	uint64_t count, sum, min, hist[LatencyBuckets];
+} Latency;
+
+static inline uint64_t rdtscp( unsigned int *cpu ) {
+#if defined( __i386 ) || defined( __x86_64 )
+	uint32_t lo, hi, aux;
+	__asm__ __volatile__ ( "rdtscp" : "=a" (lo), "=d" (hi), "=c" (aux) );
+	*cpu = aux & 0xfff;									// Linux TSC_AUX: node << 12 | cpu
+	return (uint64_t)hi << 32 | lo;
+#else
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	*cpu = sched_getcpu();
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+} // rdtscp
+
+static inline unsigned int latencyBucket( uint64_t v ) {
+	if ( v < SubBuckets ) return v;
+	unsigned int l = Log2( v );							// >= 3
+	return l * SubBuckets + ( ( v >> ( l - 3 ) ) & ( SubBuckets - 1 ) );
+} // latencyBucket
+
+static inline uint64_t latencyValue( unsigned int b ) { // lower bound of bucket
+	if ( b < SubBuckets ) return b;
+	unsigned int l = b / SubBuckets;
+	return ( (uint64_t)SubBuckets + b % SubBuckets ) << ( l - 3 );
+} // latencyValue
+
+static inline void latencyAdd( Latency *l, uint64_t v ) {
+	l->count += 1;
+	l->sum += v;
+	if ( v < l->min ) l->min = v;
+	l->hist[latencyBucket( v )] += 1;
+} // latencyAdd
+
+static uint64_t __attribute__(( unused )) latencyPercentile( const Latency *l, double p ) { // lower bound of bucket with percentile p
+	uint64_t sum = 0;
+	unsigned int b;
+	for ( b = 0; b < LatencyBuckets - 1 && ( sum += l->hist[b] ) < p * l->count; b += 1 );
+	return latencyValue( b );
+} // latencyPercentile
+
+static void __attribute__(( unused )) latencyMerge( Latency *to, const Latency *from ) {
+	to->count += from->count;
+	to->sum += from->sum;
+	if ( from->count != 0 && ( to->count == from->count || from->min < to->min ) ) to->min = from->min;
+	for ( unsigned int b = 0; b < LatencyBuckets; b += 1 ) to->hist[b] += from->hist[b];
+} // latencyMerge
+
+static double tscPerNsec;								// timestamp rate
+
+static void __attribute__(( unused )) tscCalibrate() {							// against CLOCK_MONOTONIC
+	unsigned int cpu;
+	struct timespec s, e;
+	const struct timespec cal = { 0, 20000000 };		// 20 msec
+	clock_gettime( CLOCK_MONOTONIC, &s );
+	uint64_t t0 = rdtscp( &cpu );
+	nanosleep( &cal, NULL );
+	uint64_t t1 = rdtscp( &cpu );
+	clock_gettime( CLOCK_MONOTONIC, &e );
+	tscPerNsec = ( t1 - t0 ) / ( ( e.tv_sec - s.tv_sec ) * 1E9 + ( e.tv_nsec - s.tv_nsec ) );
+} // tscCalibrate
+#endif // HANDOVER || CYCLES || BREAKDOWN || TRACE
+
+//------------------------------------------------------------------------------
+
+// Lock handover latency.  With HANDOVER, threads alternate strictly through the critical section: after a passage, a
+// thread waits in Passage until another thread has entered, so a waiter is always queued when the lock is released.
+// The holder timestamps (rdtscp, which also returns the CPU) the end of its critical section, and the next holder the
+// start of its critical section; the difference is the release-to-acquire latency, i.e., exit protocol, coherence
+// transfer and wakeup of the entry protocol.  Timestamps are only read and written in the critical section, so the
+// shared release stamp is protected by the lock under test, and the TSC is assumed synchronized (constant_tsc).
+// Latencies are classified by the CPU pair from /sys topology, and each class prints, for the median run, the
+// handovers, min, median and average nanoseconds.  Threads are pinned round-robin over the process's CPU set, so
+// "taskset -c 0,1 a.out 2 10" measures a chosen pair; script "runhandover" runs every algorithm over representative
+// pairs.
+
+#ifdef HANDOVER
+#ifdef FAST
+	#error HANDOVER requires multiple threads, not FAST
+#endif // FAST
+
+enum { SameCPU, SameCore, SameSocket, CrossSocket, Classes };
+
+static volatile uint64_t handoverTime CALIGN = 0;		// release stamp, 0 => none, protected by lock under test
+static volatile unsigned int handoverCPU, handoverHolder;
+static Latency (*handoverStats)[Classes] CALIGN;	// for each run, protected by lock under test
+static int *cpuCore, *cpuSocket, NoCPUs;				// topology
+
+static inline void handoverAcquire( TYPE id ) {
+	unsigned int cpu;
+	uint64_t t = rdtscp( &cpu );
+  if ( handoverTime == 0 || handoverHolder == id ) return; // first entry in run or no handover ?
+	unsigned int pred = handoverCPU, c;
+	if ( pred == cpu ) c = SameCPU;
+	else if ( pred >= (unsigned int)NoCPUs || cpu >= (unsigned int)NoCPUs || cpuSocket[pred] != cpuSocket[cpu] ) c = CrossSocket;
+	else c = cpuCore[pred] == cpuCore[cpu] ? SameCore : SameSocket;
+	latencyAdd( &handoverStats[CurrRun][c], t - handoverTime );
+} // handoverAcquire
+
+static inline void handoverRelease( TYPE id ) {
+	unsigned int cpu;
+	handoverHolder = id;
+	handoverTime = rdtscp( &cpu );
+	handoverCPU = cpu;
+} // handoverRelease
+
+static int topology( int cpu, const char *file ) {
+	char path[128];
+	int v = -1;
+	snprintf( path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, file );
+	FILE *f = fopen( path, "r" );
+	if ( f != NULL ) {
+		if ( fscanf( f, "%d", &v ) != 1 ) v = -1;
+		fclose( f );
+	} // if
+	return v;
+} // topology
+
+static void handoverCtor() {
+	NoCPUs = sysconf( _SC_NPROCESSORS_CONF );
+	cpuCore = malloc( sizeof(typeof(cpuCore[0])) * NoCPUs );
+	cpuSocket = malloc( sizeof(typeof(cpuSocket[0])) * NoCPUs );
+	for ( int cpu = 0; cpu < NoCPUs; cpu += 1 ) {
+		cpuCore[cpu] = topology( cpu, "core_id" );
+		cpuSocket[cpu] = topology( cpu, "physical_package_id" );
+	} // for
+	handoverStats = calloc( RUNS, sizeof(typeof(handoverStats[0])) );
+	for ( int r = 0; r < RUNS; r += 1 )
+		for ( int c = 0; c < Classes; c += 1 ) handoverStats[r][c].min = UINT64_MAX;
+	tscCalibrate();
+} // handoverCtor
+
+static void handoverPrint( unsigned int posn ) {
+	const char *names[] = { "same-cpu", "same-core", "same-socket", "cross-socket" };
+	for ( int c = 0; c < Classes; c += 1 ) {
+		Latency *s = &handoverStats[posn][c];
+	  if ( s->count == 0 ) continue;
+		printf( "\nhandover %s handovers:%ju min:%.0fns median:%.0fns avg:%.0fns", names[c], s->count,
+				s->min / tscPerNsec, latencyPercentile( s, 0.5 ) / tscPerNsec, (double)s->sum / s->count / tscPerNsec );
+	} // for
+	free( handoverStats );
+	free( cpuSocket );
+	free( cpuCore );
+} // handoverPrint
+#endif // HANDOVER
+
+//------------------------------------------------------------------------------
+
+// Uncontended cost.  With FAST and CYCLES, the single thread timestamps (rdtscp followed by lfence, so the window is
+// serialized at both ends) the end of Passage, the start and end of the critical section, and the start of the next
+// Passage, giving the cycles of the entry protocol and of the exit protocol (plus the FAST thread-id change) of each
+// passage.  The minimum cost of back-to-back timestamps is subtracted from each window.  With COLD, all program data
+// (.data and .bss) and all storage from Allocator is flushed with clflush before each passage, so every shared line of
+// the algorithm misses; otherwise the lines stay warm in the thread's cache.  For the median run, the median, minimum
+// and average cycles are printed for entry, exit and the lock/unlock pair.  Script "runcycles" tabulates all algorithms.
+
+#ifdef CYCLES
+#ifndef FAST
+	#error CYCLES measures the uncontended path, requires FAST
+#endif // ! FAST
+
+enum { CycleEntry, CycleExit, CyclePair, CycleKinds };
+static Latency (*cycleStats)[CycleKinds] CALIGN;		// for each run
+static uint64_t cycleOverhead, cycleT0, cycleT1, cycleT2; // timestamp cost, passage timestamps
+static int cycleRun = -1;								// run of cycleT0
+
+static inline uint64_t cycleStamp() {
+	unsigned int cpu;
+	uint64_t t = rdtscp( &cpu );						// wait for previous instructions
+	__asm__ __volatile__ ( "lfence" ::: "memory" );		// later instructions wait for timestamp
+	return t;
+} // cycleStamp
+
+#ifdef COLD
+extern char __data_start[], _end[];						// program data and bss, glibc linker symbols
+enum { MaxRegions = 256 };
+static struct { char *addr; size_t size; } regions[MaxRegions];
+static int NoRegions;
+
+static void *coldAllocator( size_t size ) {				// record storage to flush
+	void *addr = memalign( CACHE_ALIGN, size );
+	if ( NoRegions < MaxRegions ) {
+		regions[NoRegions].addr = addr;
+		regions[NoRegions].size = size;
+		NoRegions += 1;
+	} // if
+	return addr;
+} // coldAllocator
+#undef Allocator
+#define Allocator( size ) coldAllocator( size )
+
+static void coldFlush( char *addr, size_t size ) {
+	for ( char *p = (char *)((uintptr_t)addr & ~(uintptr_t)(CACHE_ALIGN - 1)); p < addr + size; p += CACHE_ALIGN )
+		__asm__ __volatile__ ( "clflush %0" : "+m" (*(volatile char *)p) );
+} // coldFlush
+#endif // COLD
+
+static void cyclesCtor() {
+	cycleStats = calloc( RUNS, sizeof(typeof(cycleStats[0])) );
+	for ( int r = 0; r < RUNS; r += 1 )
+		for ( int k = 0; k < CycleKinds; k += 1 ) cycleStats[r][k].min = UINT64_MAX;
+	cycleOverhead = UINT64_MAX;
+	for ( int i = 0; i < 100000; i += 1 ) {				// minimum back-to-back timestamp
+		uint64_t t0 = cycleStamp(), t1 = cycleStamp();
+		if ( t1 - t0 < cycleOverhead ) cycleOverhead = t1 - t0;
+	} // for
+} // cyclesCtor
+
+static inline uint64_t cycleWindow( uint64_t start, uint64_t end ) {
+	uint64_t d = end - start;
+	return d > cycleOverhead ? d - cycleOverhead : 0;
+} // cycleWindow
+
+static inline void cyclesPassage() {
+	uint64_t t3 = cycleStamp();
+	if ( cycleRun == CurrRun ) {						// not first passage of run ?
+		Latency *s = cycleStats[CurrRun];
+		uint64_t entry = cycleWindow( cycleT0, cycleT1 ), exit = cycleWindow( cycleT2, t3 );
+		latencyAdd( &s[CycleEntry], entry );
+		latencyAdd( &s[CycleExit], exit );
+		latencyAdd( &s[CyclePair], entry + exit );
+	} // if
+	cycleRun = CurrRun;
+#ifdef COLD
+	coldFlush( __data_start, _end - __data_start );
+	for ( int i = 0; i < NoRegions; i += 1 ) coldFlush( regions[i].addr, regions[i].size );
+	__asm__ __volatile__ ( "mfence" ::: "memory" );		// flushes complete
+#endif // COLD
+	cycleT0 = cycleStamp();
+} // cyclesPassage
+
+static void cyclesPrint( unsigned int posn ) {
+	const char *names[] = { "entry", "exit", "pair" };
+#ifdef COLD
+	printf( "\ncycles cold overhead:%ju", cycleOverhead );
+#else
+	printf( "\ncycles warm overhead:%ju", cycleOverhead );
+#endif // COLD
+	for ( int k = 0; k < CycleKinds; k += 1 ) {
+		Latency *s = &cycleStats[posn][k];
+		printf( " %s median:%ju min:%ju avg:%.1f", names[k], latencyPercentile( s, 0.5 ), s->count == 0 ? 0 : s->min,
+				s->count == 0 ? 0.0 : (double)s->sum / s->count );
+	} // for
+	free( cycleStats );
+} // cyclesPrint
+#endif // CYCLES
+
+//------------------------------------------------------------------------------
+
+// Passage phase breakdown.  With BREAKDOWN, each thread timestamps its passage into a per-thread buffer at the end of
+// the previous passage, at DoorwayEnd() (if the algorithm marks the end of its doorway), at the start and end of the
+// critical section, and at the start of Passage, and adds the phases to per-thread histograms:
+//   entry    end of previous passage to critical section
+//   doorway  end of previous passage to DoorwayEnd(), when marked
+//   wait     DoorwayEnd() to critical section, when marked
+//   cs       critical section
+//   exit     end of critical section to Passage, i.e., exit protocol (plus the FAST thread-id change)
+// For the median run, each phase prints its count and mean, median, 99th and 99.9th percentile nanoseconds.  Without
+// BREAKDOWN (or TRACE), DoorwayEnd() and all timestamps compile out.  Algorithms marking DoorwayEnd(): LamportBakery,
+// MCS, MCSTP, ElevatorQueue, RMRS.
+
+#ifdef BREAKDOWN
+enum { PhaseEntry, PhaseDoorway, PhaseWait, PhaseCS, PhaseExit, NoPhaseKinds };
+typedef struct {
+	uint64_t start, doorway, cs, exit;					// timestamps of current passage, 0 => not reached
+} PhaseStamps;
+
+static __thread PhaseStamps phaseStamps;				// thread's buffer
+static __thread int phaseThread = -1, phaseRun = -1;	// thread's statistics index and run of phaseStamps.start
+static int phaseThreads = 0, phaseMax;				// statistics indexes assigned, maximum
+static Latency **phaseStats CALIGN;						// for each run, Threads x NoPhaseKinds
+
+static inline uint64_t phaseStamp() {
+	unsigned int cpu;
+	return rdtscp( &cpu );
+} // phaseStamp
+
+#define DoorwayEnd() do { phaseStamps.doorway = phaseStamp(); TraceDoorwayEnd(); } while ( 0 )
+
+static void breakdownCtor( int threads ) {
+	phaseMax = threads;
+	phaseStats = malloc( sizeof(typeof(phaseStats[0])) * RUNS );
+	for ( int r = 0; r < RUNS; r += 1 )
+		phaseStats[r] = calloc( phaseMax * NoPhaseKinds, sizeof(typeof(phaseStats[0][0])) );
+	tscCalibrate();
+} // breakdownCtor
+
+static inline void breakdownPassage( uint64_t end ) { // end of exit protocol
+	if ( phaseRun == CurrRun ) {						// not first passage of run ?
+		if ( phaseThread == -1 ) phaseThread = __sync_fetch_and_add( &phaseThreads, 1 ) % phaseMax;
+		Latency *s = &phaseStats[CurrRun][phaseThread * NoPhaseKinds];
+		latencyAdd( &s[PhaseEntry], phaseStamps.cs - phaseStamps.start );
+		if ( phaseStamps.doorway > phaseStamps.start ) { // marked ?
+			latencyAdd( &s[PhaseDoorway], phaseStamps.doorway - phaseStamps.start );
+			latencyAdd( &s[PhaseWait], phaseStamps.cs - phaseStamps.doorway );
+		} // if
+		latencyAdd( &s[PhaseCS], phaseStamps.exit - phaseStamps.cs );
+		latencyAdd( &s[PhaseExit], end - phaseStamps.exit );
+	} // if
+	phaseRun = CurrRun;
+	phaseStamps.start = phaseStamp();
+} // breakdownPassage
+
+static void breakdownPrint( unsigned int posn ) {
+	const char *names[] = { "entry", "doorway", "wait", "cs", "exit" };
+	static Latency sum;
+	for ( int k = 0; k < NoPhaseKinds; k += 1 ) {
+		memset( &sum, 0, sizeof(sum) );
+		for ( int tid = 0; tid < phaseMax; tid += 1 ) latencyMerge( &sum, &phaseStats[posn][tid * NoPhaseKinds + k] );
+	  if ( sum.count == 0 ) continue;					// doorway not marked
+		printf( "\nbreakdown %s passages:%ju mean:%.0fns p50:%.0fns p99:%.0fns p99.9:%.0fns", names[k], sum.count,
+				(double)sum.sum / sum.count / tscPerNsec, latencyPercentile( &sum, 0.5 ) / tscPerNsec,
+				latencyPercentile( &sum, 0.99 ) / tscPerNsec, latencyPercentile( &sum, 0.999 ) / tscPerNsec );
+	} // for
+	for ( int r = 0; r < RUNS; r += 1 ) free( phaseStats[r] );
+	free( phaseStats );
+} // breakdownPrint
+#else
+#define DoorwayEnd() TraceDoorwayEnd()
+#endif // BREAKDOWN
+
+//------------------------------------------------------------------------------
+
+// Remote-memory-reference (RMR) tracing.  With RMR, an algorithm's shared accesses made through the accessor macros
+//   LD( x )      load of shared variable x
+//   ST( x, v )   store of v into x
+//   RMW( x )     address of x for an atomic instruction, e.g., __sync_bool_compare_and_swap( RMW( x ), c, s )
+// and every Fence() are logged as (time, thread, address, kind) into a per-thread buffer of RMRLOG records, with the
+// marks RmrEnter/RmrExit at the start/end of the critical section and RmrDone in Passage.  Consecutive reads of the
+// same address, i.e., a busy wait, are logged as the first read and an RmrSpin record holding the time of the last
+// read.  Each thread yields its CPU after a passage, so with more threads than CPUs, e.g., 128 threads on a small
+// machine, passages interleave across threads rather than run in timeslices.  Logging stops when a buffer is full, so
+// run briefly.  At exit, the buffers are written to RMRFILE for the offline coherence simulator
+// tools/RMRSim.cc.  Without RMR, the macros are the plain accesses.  Algorithms using the accessors: MCS,
+// LamportBakery, RMRS, Triangle (Peterson matches), ElevatorQueue.
+
+enum { RmrRead, RmrWrite, RmrAtomic, RmrFence, RmrEnter, RmrExit, RmrDone, RmrSpin };
+
+#ifdef RMR
+#ifndef RMRLOG
+#define RMRLOG 65536									// records per thread
+#endif // ! RMRLOG
+#ifndef RMRFILE
+#define RMRFILE "rmr.trace"
+#endif // ! RMRFILE
+
+typedef struct {										// trace file layout, see tools/RMRSim.cc
+	uint64_t time;										// TSC cycles
+	uint64_t addr;										// 0 => fence or mark
+	uint32_t thread, kind;
+} RmrRecord;
+
+typedef struct {
+	char magic[8];										// "RMRTRACE"
+	char algorithm[32];
+	uint32_t threads, capacity;							// logs, records per log
+	uint32_t N, line;									// algorithm threads, cache-line size
+} RmrHeader;											// followed by threads record counts and the logs
+
+static RmrRecord **rmrLogs CALIGN;						// per thread
+static int rmrThreads = 0, rmrMax;						// logs assigned, maximum
+static __thread RmrRecord *rmrNext, *rmrEnd, *rmrLast;	// thread's log
+static __thread int rmrThread = -1;						// -1 => unassigned, -2 => driver or no log
+
+static inline uint64_t rmrStamp() {
+#if defined( __i386 ) || defined( __x86_64 )
+	uint32_t lo, hi;
+	__asm__ __volatile__ ( "rdtsc" : "=a" (lo), "=d" (hi) );
+	return (uint64_t)hi << 32 | lo;
+#else
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+} // rmrStamp
+
+static int __attribute__((noinline)) rmrAssign() {		// 0 => no log
+  if ( rmrThread != -1 ) return 0;						// full or driver
+	rmrThread = __sync_fetch_and_add( &rmrThreads, 1 );
+	if ( rmrThread >= rmrMax ) { rmrThread = -2; return 0; }
+	rmrNext = rmrLogs[rmrThread];
+	rmrEnd = rmrNext + RMRLOG;
+	return 1;
+} // rmrAssign
+
+static inline void rmrLog( const volatile void *addr, unsigned int kind ) {
+	if ( kind == RmrRead && rmrLast != NULL && rmrLast->addr == (uintptr_t)addr && ( rmrLast->kind == RmrRead || rmrLast->kind == RmrSpin ) ) {
+		if ( rmrLast->kind == RmrSpin ) {				// still waiting ?
+			rmrLast->time = rmrStamp();
+			return;
+		} // if
+		kind = RmrSpin;									// second read starts busy wait
+	} // if
+  if ( SLOWPATH( rmrNext == rmrEnd ) && ! rmrAssign() ) return;
+	*rmrNext = (RmrRecord){ rmrStamp(), (uintptr_t)addr, rmrThread, kind };
+	rmrLast = rmrNext;
+	rmrNext += 1;
+} // rmrLog
+
+static void rmrCtor( int threads ) {
+	rmrThread = -2;										// driver does not log
+	rmrMax = threads;
+	rmrLogs = malloc( sizeof(typeof(rmrLogs[0])) * rmrMax );
+	for ( int tid = 0; tid < rmrMax; tid += 1 )
+		rmrLogs[tid] = calloc( RMRLOG, sizeof(typeof(rmrLogs[0][0])) ); // time 0 => unused
+} // rmrCtor
+
+static void rmrWrite( const char *algorithm, int n ) {
+	RmrHeader h = { "RMRTRACE", "", rmrMax, RMRLOG, n, CACHE_ALIGN };
+	strncpy( h.algorithm, algorithm, sizeof(h.algorithm) - 1 );
+	uint64_t counts[rmrMax], records = 0;
+	for ( int tid = 0; tid < rmrMax; tid += 1 ) {
+		for ( counts[tid] = 0; counts[tid] < RMRLOG && rmrLogs[tid][counts[tid]].time != 0; counts[tid] += 1 );
+		records += counts[tid];
+	} // for
+	FILE *trace = fopen( RMRFILE, "w" );
+	if ( trace == NULL ) {
+		perror( RMRFILE );
+		abort();
+	} // if
+	fwrite( &h, sizeof(h), 1, trace );
+	fwrite( counts, sizeof(counts[0]), rmrMax, trace );
+	for ( int tid = 0; tid < rmrMax; tid += 1 ) {
+		fwrite( rmrLogs[tid], sizeof(rmrLogs[0][0]), counts[tid], trace );
+		free( rmrLogs[tid] );
+	} // for
+	fclose( trace );
+	free( rmrLogs );
+	printf( "\nrmr trace:%s records:%ju", RMRFILE, records );
+} // rmrWrite
+
+static inline void rmrFence() { Fence(); }				// untraced
+#undef Fence
+#define Fence() do { rmrLog( NULL, RmrFence ); rmrFence(); } while ( 0 )
+
+#define LD( x ) ({ typeof(&(x)) rmr_ = &(x); rmrLog( rmr_, RmrRead ); *rmr_; })
+#define ST( x, v ) ({ typeof(&(x)) rmr_ = &(x); rmrLog( rmr_, RmrWrite ); *rmr_ = (v); })
+#define RMW( x ) ({ typeof(&(x)) rmr_ = &(x); rmrLog( rmr_, RmrAtomic ); rmr_; })
+#define RmrMark( kind ) rmrLog( NULL, kind )
+#define RmrYield() sched_yield()
+#else
+#define LD( x ) (x)
+#define ST( x, v ) ((x) = (v))
+#define RMW( x ) (&(x))
+#define RmrMark( kind )
+#define RmrYield()
+#endif // RMR
+
+//------------------------------------------------------------------------------
+
+// Lock ownership trace.  With TRACE, each thread appends (timestamp, CPU, run, id, event) to its own ring of TRACELOG
+// (power of 2) events, overwriting its oldest events, where the events are:
+//   arrive   end of previous passage, i.e., start of the entry protocol
+//   doorway  DoorwayEnd(), for algorithms marking it (see BREAKDOWN)
+//   enter    start of critical section
+//   exit     end of critical section
+//   done     end of exit protocol
+// An event is a rdtscp and a store into the thread's ring, and the rings are only read after the run.  At exit, they
+// are written to TRACEFILE for tools/LockTrace.cc, which merges them into Chrome/Perfetto trace JSON and computes FCFS
+// violations, bypasses, handover gaps and convoys.
+
+enum { TraceArrive, TraceDoorway, TraceEnter, TraceExit, TraceDone };
+
+#ifdef TRACE
+#ifndef TRACELOG
+#define TRACELOG 65536									// events per thread, power of 2
+#endif // ! TRACELOG
+#ifndef TRACEFILE
+#define TRACEFILE "lock.trace"
+#endif // ! TRACEFILE
+
+typedef struct {										// trace file layout, see tools/LockTrace.cc
+	uint64_t time;										// TSC cycles
+	uint32_t id;										// algorithm thread id
+	uint16_t thread, cpu;
+	uint8_t event, run;
+} TraceEvent;
+
+typedef struct {
+	char magic[8];										// "LOCKTRCE"
+	char algorithm[32];
+	uint32_t threads, capacity;							// rings, events per ring
+	uint32_t N, unused;
+	double tscPerNsec;
+} TraceHeader;											// followed by threads event counts and the rings, oldest first
+
+typedef struct CALIGN {
+	uint64_t count;										// events appended
+	TraceEvent *events;
+} TraceRing;
+
+static TraceRing *traceRings CALIGN;					// per thread
+static int traceThreads = 0, traceMax;					// rings assigned, maximum
+static __thread TraceRing *traceRing;					// thread's ring
+static __thread int traceThread = -1;					// -1 => unassigned, -2 => driver or no ring
+static __thread uint32_t traceId = ~0u;					// id of current passage, for DoorwayEnd
+
+static int __attribute__((noinline)) traceAssign() {	// 0 => no ring
+  if ( traceThread != -1 ) return 0;					// driver
+	traceThread = __sync_fetch_and_add( &traceThreads, 1 );
+	if ( traceThread >= traceMax ) { traceThread = -2; return 0; }
+	traceRing = &traceRings[traceThread];
+	return 1;
+} // traceAssign
+
+static inline void traceEvent( uint32_t id, unsigned int event ) {
+  if ( SLOWPATH( traceRing == NULL ) && ! traceAssign() ) return;
+	unsigned int cpu;
+	uint64_t time = rdtscp( &cpu );
+	traceRing->events[traceRing->count & (TRACELOG - 1)] = (TraceEvent){ time, id, traceThread, cpu, event, CurrRun };
+	traceRing->count += 1;
+} // traceEvent
+
+static void traceCtor( int threads ) {
+	_Static_assert( (TRACELOG & (TRACELOG - 1)) == 0, "TRACELOG must be a power of 2" );
+	traceThread = -2;									// driver does not trace
+	traceMax = threads;
+	traceRings = Allocator( sizeof(typeof(traceRings[0])) * traceMax );
+	for ( int tid = 0; tid < traceMax; tid += 1 ) {
+		traceRings[tid].count = 0;
+		traceRings[tid].events = malloc( sizeof(typeof(traceRings[0].events[0])) * TRACELOG );
+	} // for
+	tscCalibrate();
+} // traceCtor
+
+static void traceWrite( const char *algorithm, int n ) {
+	TraceHeader h = { "LOCKTRCE", "", traceMax, TRACELOG, n, 0, tscPerNsec };
+	strncpy( h.algorithm, algorithm, sizeof(h.algorithm) - 1 );
+	uint64_t counts[traceMax], events = 0;
+	for ( int tid = 0; tid < traceMax; tid += 1 ) {
+		counts[tid] = traceRings[tid].count < TRACELOG ? traceRings[tid].count : TRACELOG;
+		events += counts[tid];
+	} // for
+	FILE *trace = fopen( TRACEFILE, "w" );
+	if ( trace == NULL ) {
+		perror( TRACEFILE );
+		abort();
+	} // if
+	fwrite( &h, sizeof(h), 1, trace );
+	fwrite( counts, sizeof(counts[0]), traceMax, trace );
+	for ( int tid = 0; tid < traceMax; tid += 1 ) {
+		TraceRing *r = &traceRings[tid];
+		uint64_t oldest = r->count < TRACELOG ? 0 : r->count & (TRACELOG - 1);
+		fwrite( &r->events[oldest], sizeof(r->events[0]), counts[tid] - oldest, trace ); // oldest to end of ring
+		fwrite( r->events, sizeof(r->events[0]), oldest, trace ); // wrapped part
+		free( r->events );
+	} // for
+	fclose( trace );
+	free( traceRings );
+	printf( "\ntrace file:%s events:%ju", TRACEFILE, events );
+} // traceWrite
+
+#define TraceMark( id, event ) traceEvent( id, event )
+#define TraceArrival( id ) traceEvent( traceId = id, TraceArrive )
+#define TraceDoorwayEnd() traceEvent( traceId, TraceDoorway )
+#else
+#define TraceMark( id, event )
+#define TraceArrival( id )
+#define TraceDoorwayEnd()
+#endif // TRACE
+
+//------------------------------------------------------------------------------
+
+#ifdef PHASES
+static volatile int CSLength CALIGN = 100;				// critical-section delay, set by each phase
+#else
+enum { CSLength = 100 };								// critical-section delay
+#endif // PHASES
+
 static inline void CriticalSection( const TYPE id ) {
 	static ATYPE CurrTid CALIGN;						// shared, current thread id in critical section
 
+#ifdef HANDOVER
+	handoverAcquire( id );
+#endif // HANDOVER
+#ifdef CYCLES
+	cycleT1 = cycleStamp();
+#endif // CYCLES
+#ifdef BREAKDOWN
+	phaseStamps.cs = phaseStamp();
+#endif // BREAKDOWN
+	RmrMark( RmrEnter );
+	TraceMark( id, TraceEnter );
 	CurrTid = id;
 	Fence();
-	for ( int i = 1; i <= 100; i += 1 ) {				// delay
+	for ( int i = 1; i <= CSLength; i += 1 ) {			// delay
 		if ( CurrTid != id ) {							// mutual exclusion violation ?
 			printf( "Interference Id:%zu\n", id );
 			abort();
 		} // if
 	} // for
+	Delay( DelayCS );									// preempted holder
+#ifdef HANDOVER
+	handoverRelease( id );
+#endif // HANDOVER
+#ifdef CYCLES
+	cycleT2 = cycleStamp();
+#endif // CYCLES
+#ifdef BREAKDOWN
+	phaseStamps.exit = phaseStamp();
+#endif // BREAKDOWN
+	RmrMark( RmrExit );
+	TraceMark( id, TraceExit );
 } // CriticalSection
 
 //------------------------------------------------------------------------------
@@ -171,6 +828,74 @@ static inline void CriticalSection( const TYPE id ) {
 static ATYPE stop CALIGN = 0;
 static ATYPE Arrived CALIGN = 0;
 static int N CALIGN, Threads CALIGN, Time CALIGN, Degree CALIGN = -1;
+static uint64_t **entries CALIGN;						// holds CS entry results for each threads for all runs
+
+static int compare( const void *p1, const void *p2 ) {
+	size_t i = *((size_t *)p1);
+	size_t j = *((size_t *)p2);
+	return i > j ? 1 : i < j ? -1 : 0;
+} // compare
+
+//------------------------------------------------------------------------------
+
+// Named counters.  With CNT, an algorithm declares a list of counters and increments them with Count, e.g.:
+//
+//   #define COUNTERS( C ) C( fast ) C( slow )
+//   DeclareCounters( COUNTERS )
+//   ...  Count( fast );
+//
+// Every algorithm also counts its Pause() (pause) and Fence() (fence) executions.  Counters are cache-padded for each
+// run and thread.  A thread reaches its counters through its own cache-padded slot, which the driver points at a
+// discard row when it sets the stop flag and at the next run's counters at the run barrier, so a count reads no shared
+// variable on the spin paths being measured; counts by the driver and between runs are discarded.  After the result
+// line, each run prints its entries and, for each counter, the total and rate per entry ("*" marks the median run).
+// Without CNT, DeclareCounters and Count compile out and Pause/Fence are the plain instructions.
+
+static inline void cpuPause() { Pause(); }				// uncounted
+static inline void cpuFence() { Fence(); }
+
+#ifdef CNT
+enum { Counter_pause, Counter_fence, BuiltinCounters, MaxCounters = 32 };
+#define COUNTER_ENUM( name ) Counter_##name,
+#define COUNTER_NAME( name ) #name,
+#define DeclareCounters( LIST ) \
+	enum { Counter_builtin = BuiltinCounters - 1, LIST( COUNTER_ENUM ) NoCounters }; \
+	static const char *counterNames[] = { "pause", "fence", LIST( COUNTER_NAME ) };
+
+typedef struct CALIGN {
+	uint64_t *volatile counts;							// thread's counters in current run, set by driver
+} CounterSlot;
+
+static uint64_t *counters CALIGN;						// (runs + 1) x threads x counterStride, last row discarded
+static CounterSlot *counterSlots;						// for each thread
+static unsigned int counterStride, counterThreads = 0;	// cache-padded counters, slots assigned
+static uint64_t countDummy[MaxCounters];				// driver's discarded counts
+static CounterSlot countDriver = { countDummy };
+static __thread CounterSlot *countSlot;					// NULL => unassigned
+
+static void __attribute__((noinline)) counterAssign() {
+	countSlot = &counterSlots[__sync_fetch_and_add( &counterThreads, 1 ) % Threads];
+} // counterAssign
+
+static inline uint64_t *counterSlot() {
+  if ( SLOWPATH( countSlot == NULL ) ) counterAssign();
+	return countSlot->counts;
+} // counterSlot
+
+static void counterRedirect( int r ) {					// driver, r == RUNS => discard
+	for ( int t = 0; t < Threads; t += 1 ) counterSlots[t].counts = &counters[( (size_t)r * Threads + t ) * counterStride];
+} // counterRedirect
+
+#define Count( name ) ( counterSlot()[Counter_##name] += 1 )
+
+#undef Pause
+#define Pause() do { Count( pause ); cpuPause(); } while ( 0 )
+#undef Fence
+#define Fence() do { Count( fence ); cpuFence(); } while ( 0 )
+#else
+#define DeclareCounters( LIST )
+#define Count( name )
+#endif // CNT
 
 //------------------------------------------------------------------------------
 
@@ -293,15 +1018,504 @@ static int __attribute__((noinline)) PollBarrier() {
 
 //------------------------------------------------------------------------------
 
+// Measured phase-changing load.  PHASES is a schedule of phases, "T:msec:cs T:msec:cs ...", where in each phase only
+// threads with id < T enter the critical section (T <= N), for msec milliseconds, with a critical-section delay of cs
+// iterations (default 100).  Each run executes the whole schedule, during which the driver samples the aggregate entry
+// count every PHASESLOT microseconds.  For each phase, the median over the runs is printed of:
+//   throughput  entries per second over the whole phase
+//   steady      entries per second over the second half of the phase (median slot)
+//   recovery    msec from the start of the phase until a slot first reaches 90% of steady
+// Threads idle in a phase busy wait outside the critical section, as for STRESSINTERVAL.
+
+#ifdef PHASES
+#ifdef FAST
+	#error PHASES requires multiple threads, not FAST
+#endif // FAST
+#ifndef PHASESLOT
+#define PHASESLOT 1000									// usec
+#endif // ! PHASESLOT
+
+enum { MaxPhases = 64 };
+typedef struct {
+	int level, msec, cs;								// concurrency level, duration, critical-section delay
+	double *throughput, *steady, *recovery;				// results for each run
+} Phase;
+static Phase phases[MaxPhases];
+static int NoPhases;
+static volatile int PhaseLevel CALIGN;					// threads with id < PhaseLevel are active
+
+typedef struct CALIGN {
+	volatile uint64_t cnt;
+} PhaseCount;
+static PhaseCount *phaseCounts CALIGN;					// entries for each thread, sampled by driver
+
+static void phasesParse() {
+	char spec[] = PHASES, *save;
+	for ( char *ph = strtok_r( spec, " ,", &save ); ph != NULL; ph = strtok_r( NULL, " ,", &save ) ) {
+		Phase *p = &phases[NoPhases];
+		p->cs = 100;
+		if ( NoPhases == MaxPhases || sscanf( ph, "%d:%d:%d", &p->level, &p->msec, &p->cs ) < 2 ||
+			 p->level < 1 || p->msec < 1 || p->cs < 1 ) {
+			printf( "Usage: PHASES \"T:msec:cs ...\", with at most %d phases, bad phase \"%s\"\n", MaxPhases, ph );
+			exit( EXIT_FAILURE );
+		} // if
+		if ( p->level > Threads ) p->level = Threads;
+		p->throughput = malloc( sizeof(typeof(p->throughput[0])) * RUNS );
+		p->steady = malloc( sizeof(typeof(p->steady[0])) * RUNS );
+		p->recovery = malloc( sizeof(typeof(p->recovery[0])) * RUNS );
+		NoPhases += 1;
+	} // for
+	if ( NoPhases == 0 ) {
+		printf( "Usage: PHASES is empty\n" );
+		exit( EXIT_FAILURE );
+	} // if
+	phaseCounts = Allocator( sizeof(typeof(phaseCounts[0])) * Threads );
+	for ( int tid = 0; tid < Threads; tid += 1 ) phaseCounts[tid].cnt = 0;
+	PhaseLevel = phases[0].level;
+	CSLength = phases[0].cs;
+} // phasesParse
+
+static inline double now() {							// seconds
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec / 1E9;
+} // now
+
+static uint64_t phasesSample() {
+	uint64_t sum = 0;
+	for ( int tid = 0; tid < Threads; tid += 1 ) sum += phaseCounts[tid].cnt;
+	return sum;
+} // phasesSample
+
+static int dcompare( const void *p1, const void *p2 ) {
+	double i = *((double *)p1), j = *((double *)p2);
+	return i > j ? 1 : i < j ? -1 : 0;
+} // dcompare
+
+static void phasesRun( int r ) {						// driver, one pass over the schedule
+	const struct timespec slot = { PHASESLOT / 1000000, PHASESLOT % 1000000 * 1000 };
+	for ( int ph = 0; ph < NoPhases; ph += 1 ) {
+		Phase *p = &phases[ph];
+		int slots = p->msec * 1000 / PHASESLOT;
+		if ( slots < 2 ) slots = 2;
+		double rates[slots], sorted[slots];
+
+		CSLength = p->cs;
+		PhaseLevel = p->level;
+		double start = now(), prevt = start;
+		uint64_t first = phasesSample(), prev = first;
+		for ( int s = 0; s < slots; s += 1 ) {
+			nanosleep( &slot, NULL );
+			double t = now();
+			uint64_t c = phasesSample();
+			rates[s] = (c - prev) / (t - prevt);
+			prev = c;
+			prevt = t;
+		} // for
+		p->throughput[r] = (prev - first) / (prevt - start);
+
+		int half = slots / 2;
+		for ( int s = half; s < slots; s += 1 ) sorted[s - half] = rates[s];
+		qsort( sorted, slots - half, sizeof(typeof(sorted[0])), dcompare );
+		p->steady[r] = sorted[(slots - half) / 2];
+		int s;
+		for ( s = 0; s < slots && rates[s] < 0.9 * p->steady[r]; s += 1 );
+		p->recovery[r] = (s + 1) * PHASESLOT / 1000.0;
+	} // for
+	PhaseLevel = phases[0].level;						// next run starts at first phase
+	CSLength = phases[0].cs;
+} // phasesRun
+
+static void phasesPrint() {
+	for ( int ph = 0; ph < NoPhases; ph += 1 ) {
+		Phase *p = &phases[ph];
+		qsort( p->throughput, RUNS, sizeof(typeof(p->throughput[0])), dcompare );
+		qsort( p->steady, RUNS, sizeof(typeof(p->steady[0])), dcompare );
+		qsort( p->recovery, RUNS, sizeof(typeof(p->recovery[0])), dcompare );
+		printf( "\nphase %d T:%d msec:%d cs:%d throughput:%.0f steady:%.0f recovery:%.3f",
+				ph, p->level, p->msec, p->cs, median( p->throughput ), median( p->steady ), median( p->recovery ) );
+		free( p->recovery );
+		free( p->steady );
+		free( p->throughput );
+	} // for
+	free( (void *)phaseCounts );
+} // phasesPrint
+#endif // PHASES
+
+#ifdef DELAY
+enum { DelayBuckets = 64 };
+typedef uint64_t DelayHist[DelayBuckets];				// passages with log2(nsec) == bucket
+static DelayHist **delayHists CALIGN;					// histogram for each run and thread
+static uint64_t **delayCounts CALIGN;					// stalls for each run and thread
+
+static void delayParse() {
+	char spec[] = DELAY, kind[8] = "";
+	const char *points[] = { "cs", "doorway", "waiter" };
+	char where[8];
+	if ( sscanf( spec, "%7[a-z]:%d:%d:%7s", where, &delayPermille, &delayUsec, kind ) < 3 ||
+		 delayPermille < 0 || delayPermille > 1000 || delayUsec < 0 || ( kind[0] != '\0' && strcmp( kind, "spin" ) != 0 ) ) goto usage;
+	for ( delayWhere = 0; delayWhere < 3 && strcmp( where, points[delayWhere] ) != 0; delayWhere += 1 );
+	if ( delayWhere == 3 ) goto usage;
+	delaySpin = kind[0] != '\0';
+	delayHists = malloc( sizeof(typeof(delayHists[0])) * RUNS );
+	delayCounts = malloc( sizeof(typeof(delayCounts[0])) * RUNS );
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		delayHists[r] = calloc( Threads, sizeof(typeof(delayHists[0][0])) );
+		delayCounts[r] = calloc( Threads, sizeof(typeof(delayCounts[0][0])) );
+	} // for
+	return;
+  usage:
+	printf( "Usage: DELAY \"where:permille:usec[:spin]\", where is cs, doorway or waiter, bad delay \"%s\"\n", spec );
+	exit( EXIT_FAILURE );
+} // delayParse
+
+static inline void delayPassage( TYPE id ) {
+	static __thread uint64_t last;						// end of thread's previous passage
+	static __thread int lastRun = -1;
+	uint64_t t = nsec();
+	int r = CurrRun;
+	if ( lastRun == r ) {								// not first passage of run ?
+		delayHists[r][id][Log2( ( t - last ) | 1 )] += 1;
+	} else {
+		if ( lastRun == -1 ) delaySeed = id * 2654435761u + 1;
+		lastRun = r;
+		delayStalls = 0;
+	} // if
+	delayCounts[r][id] = delayStalls;
+	last = t;
+} // delayPassage
+
+static double delayPercentile( DelayHist hist, uint64_t total, double p ) { // upper bucket bound, usec
+	uint64_t sum = 0;
+	int b;
+	for ( b = 0; b < DelayBuckets - 1 && ( sum += hist[b] ) < p * total; b += 1 );
+	return (double)(2ull << b) / 1000.0;
+} // delayPercentile
+
+static void delayPrint( unsigned int posn ) {
+	DelayHist hist = { 0 };
+	uint64_t total = 0, stalls = 0;
+	int max = 0;
+	for ( int tid = 0; tid < Threads; tid += 1 ) {
+		for ( int b = 0; b < DelayBuckets; b += 1 ) {
+			hist[b] += delayHists[posn][tid][b];
+			total += delayHists[posn][tid][b];
+			if ( delayHists[posn][tid][b] != 0 && b > max ) max = b;
+		} // for
+		stalls += delayCounts[posn][tid];
+	} // for
+	printf( "\ndelay %s stalls:%ju passage(us) p50:%.1f p99:%.1f p99.9:%.1f max:%.1f",
+			DELAY, stalls, delayPercentile( hist, total, 0.5 ), delayPercentile( hist, total, 0.99 ),
+			delayPercentile( hist, total, 0.999 ), (double)(2ull << max) / 1000.0 );
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		free( delayCounts[r] );
+		free( delayHists[r] );
+	} // for
+	free( delayCounts );
+	free( delayHists );
+} // delayPrint
+#endif // DELAY
+
+// Start gate and measurement modes.  By default, a run is the Time seconds between the driver starting (or restarting)
+// the workers and stopping them, so its count includes the threads' spin-up skew.  With WORK, WINDOW or PRECISION, each
+// run begins at a common start gate: every thread makes one uncounted passage and waits in Passage until all threads
+// have arrived, when the driver opens the gate and starts timing.  The harness then counts each thread's passages,
+// which replace the workers' entry counts.
+//   WORK=M           fixed work: a run ends when the threads have made M entries in total.  Each thread adds its count
+//                    to a shared total in batches (at most 256, and small enough for about 64 batches per thread), and
+//                    the thread whose batch reaches M takes the time, sums the threads' counts and stops the run, so the
+//                    driver sleeps meanwhile.  The median run prints the time for M entries (elapsed time scaled by M /
+//                    counted entries, as the batches overshoot) and the rate.  Time is ignored.
+//   WINDOW="w:m:c"   sub-second window: after the gate, w milliseconds of warm-up, m milliseconds measured and c
+//                    milliseconds of cool-down (fractions allowed), and only the entries in the m milliseconds count.
+//                    Time is ignored.
+//   PRECISION=P      adaptive stopping: after one PRECISIONSLICE warm-up slice (milliseconds, default 100), a run is
+//                    measured in slices of PRECISIONSLICE and ends once it has PRECISIONMIN slices (default 10) and the
+//                    95% confidence interval of the mean entries per slice (batch means, Student's t) is within +-P
+//                    percent, or when Time seconds, the budget of a run, have passed.  Entries are scaled to Time
+//                    seconds, so results compare with runs without PRECISION.  The median run prints its interval and
+//                    slices, and the point prints the interval over the RUNS runs and the time used out of the RUNS x
+//                    Time budget.
+
+#if defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+#if defined( WORK ) + defined( WINDOW ) + defined( PRECISION ) > 1
+	#error WORK, WINDOW and PRECISION are alternative measurements
+#endif // WORK + WINDOW + PRECISION > 1
+#if defined( PHASES ) || defined( STRESSINTERVAL ) || defined( HANDOVER )
+	#error WORK, WINDOW and PRECISION are not combined with PHASES, STRESSINTERVAL or HANDOVER
+#endif // PHASES || STRESSINTERVAL || HANDOVER
+#ifdef PRECISION
+#ifndef PRECISIONSLICE
+#define PRECISIONSLICE 100								// msec
+#endif // ! PRECISIONSLICE
+#ifndef PRECISIONMIN
+#define PRECISIONMIN 10									// slices
+#endif // ! PRECISIONMIN
+#endif // PRECISION
+
+typedef struct CALIGN {
+	volatile uint64_t count;							// thread's passages after gates
+} GateCount;
+
+static GateCount *gateCounts CALIGN;					// for each thread
+static uint64_t *gateBase, *gateEnd;					// counts at start and end of measurement
+static volatile int gateArrived CALIGN = 0, gateOpened = 0; // threads arrived at gate over all runs, runs opened
+static uint64_t gateTimes[RUNS];						// measured nsec of each run
+static __thread GateCount *gateCount;					// thread's counter in current run
+static __thread int gateRun = -1;						// run of thread's last gate
+static uint64_t gateStart;								// nsec of opening
+#ifdef WORK
+static volatile uint64_t workTotal CALIGN;				// batched entries in current run
+static uint64_t workBatch, workCounted[RUNS];			// power of 2, entries counted when total reached WORK
+static sem_t workDone;
+#endif // WORK
+#ifdef WINDOW
+static double windowMsec[3];							// warm-up, measured, cool-down
+#endif // WINDOW
+#ifdef PRECISION
+static double precisionRun[RUNS];						// relative half width of each run's interval
+static unsigned int precisionSlices[RUNS];
+#endif // PRECISION
+
+static void gateCtor( int threads ) {
+#ifdef WINDOW
+	char c;
+	if ( sscanf( WINDOW, "%lf:%lf:%lf%c", &windowMsec[0], &windowMsec[1], &windowMsec[2], &c ) != 3 ||
+		 windowMsec[0] < 0 || windowMsec[1] <= 0 || windowMsec[2] < 0 ) {
+		printf( "Usage: WINDOW \"warmup:measured:cooldown\" milliseconds, bad window \"%s\"\n", WINDOW );
+		exit( EXIT_FAILURE );
+	} // if
+#endif // WINDOW
+#ifdef WORK
+	for ( workBatch = 256; workBatch > 1 && workBatch * 64 * threads > (uint64_t)WORK; workBatch /= 2 );
+	sem_init( &workDone, 0, 0 );
+#endif // WORK
+	gateCounts = Allocator( sizeof(typeof(gateCounts[0])) * threads );
+	memset( (void *)gateCounts, 0, sizeof(typeof(gateCounts[0])) * threads );
+	gateBase = malloc( sizeof(typeof(gateBase[0])) * threads );
+	gateEnd = malloc( sizeof(typeof(gateEnd[0])) * threads );
+} // gateCtor
+
+static void gateDtor() {
+#ifdef WORK
+	sem_destroy( &workDone );
+#endif // WORK
+	free( gateEnd );
+	free( gateBase );
+	free( (void *)gateCounts );
+} // gateDtor
+
+static void __attribute__((noinline)) gateWait() {		// first passage of run
+	gateCount = &gateCounts[__sync_fetch_and_add( &gateArrived, 1 ) % Threads]; // 0..Threads-1 each run
+	gateRun = CurrRun;
+	while ( gateOpened <= gateRun ) cpuPause();			// wait for all threads
+} // gateWait
+
+#ifdef WORK
+static void __attribute__((noinline)) workAdd() {		// add batch to total
+	uint64_t total = __sync_add_and_fetch( &workTotal, workBatch );
+  if ( total < (uint64_t)WORK || total - workBatch >= (uint64_t)WORK ) return; // not reaching WORK ?
+	uint64_t end = nsec(), sum = 0;
+	for ( int t = 0; t < Threads; t += 1 ) sum += gateCounts[t].count - gateBase[t];
+	gateTimes[CurrRun] = end - gateStart;
+	workCounted[CurrRun] = sum;
+	stop = 1;											// end run
+	sem_post( &workDone );
+} // workAdd
+#endif // WORK
+
+static inline void gatePassage() {
+  if ( SLOWPATH( gateRun != CurrRun ) ) { gateWait(); return; } // gate passage uncounted
+#ifdef WORK
+	if ( SLOWPATH( ( ( gateCount->count += 1 ) & ( workBatch - 1 ) ) == 0 ) ) workAdd();
+#else
+	gateCount->count += 1;
+#endif // WORK
+} // gatePassage
+
+static void gateSnapshot( uint64_t counts[] ) {
+	for ( int t = 0; t < Threads; t += 1 ) counts[t] = gateCounts[t].count;
+} // gateSnapshot
+
+#if defined( WINDOW ) || defined( PRECISION )
+static void sleepUntil( uint64_t ns ) {					// CLOCK_MONOTONIC
+	const struct timespec t = { ns / 1000000000, ns % 1000000000 };
+	while ( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL ) == EINTR );
+} // sleepUntil
+#endif // WINDOW || PRECISION
+
+#ifdef PRECISION
+static double tQuantile( int df ) {						// two-sided 95% Student's t
+	static const double t[] = { 0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179,
+								2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060,
+								2.056, 2.052, 2.048, 2.045, 2.042 };
+	return df < (int)( sizeof(t) / sizeof(t[0]) ) ? t[df] : 1.960;
+} // tQuantile
+
+static double precisionHalfWidth( unsigned int n, double mean, double m2 ) { // relative, from Welford mean and sum of squares
+	if ( n < 2 ) return INFINITY;
+	if ( mean == 0.0 ) return m2 == 0.0 ? 0.0 : INFINITY;
+	return tQuantile( n - 1 ) * sqrt( m2 / ( n - 1 ) / n ) / mean;
+} // precisionHalfWidth
+#endif // PRECISION
+
+static void gateMeasure( int r ) {						// open gate and measure run r
+	while ( gateArrived != Threads * ( r + 1 ) ) Pause(); // all threads at gate
+	gateSnapshot( gateBase );							// stable, threads waiting
+#ifdef WORK
+	workTotal = 0;
+#endif // WORK
+	gateStart = nsec();
+	gateOpened = r + 1;
+#if defined( WORK )
+	while ( sem_wait( &workDone ) != 0 );				// thread reaching WORK stops run
+#elif defined( WINDOW )
+	sleepUntil( gateStart + windowMsec[0] * 1E6 );		// warm-up
+	gateSnapshot( gateBase );
+	uint64_t start = nsec();
+	sleepUntil( start + windowMsec[1] * 1E6 );			// measured
+	gateSnapshot( gateEnd );
+	uint64_t end = nsec();
+	gateTimes[r] = end - start;
+	sleepUntil( end + windowMsec[2] * 1E6 );			// cool-down
+#else
+	const uint64_t slice = PRECISIONSLICE * 1000000ull, budget = Time * 1000000000ull;
+	sleepUntil( gateStart + slice );					// warm-up
+	gateSnapshot( gateBase );
+	uint64_t start = nsec(), end = start, prev = 0;
+	unsigned int n = 0;
+	double mean = 0.0, m2 = 0.0;
+	for ( uint64_t wake = start; end - gateStart < budget; ) {
+		sleepUntil( wake += slice );
+		gateSnapshot( gateEnd );
+		end = nsec();
+		uint64_t total = 0;
+		for ( int t = 0; t < Threads; t += 1 ) total += gateEnd[t] - gateBase[t];
+		double x = total - prev, delta = x - mean;		// entries in slice
+		prev = total;
+		n += 1;
+		mean += delta / n;
+		m2 += delta * ( x - mean );
+	  if ( n >= PRECISIONMIN && precisionHalfWidth( n, mean, m2 ) * 100.0 <= PRECISION ) break; // precise enough ?
+	} // for
+	gateTimes[r] = end - start;
+	precisionSlices[r] = n;
+	precisionRun[r] = precisionHalfWidth( n, mean, m2 );
+#endif // WORK
+} // gateMeasure
+
+static void gateResults( int r ) {						// after workers store their counts
+#ifdef WORK
+	gateSnapshot( gateEnd );							// threads stopped
+#endif // WORK
+#ifdef PRECISION
+	double scale = gateTimes[r] == 0 ? 0.0 : Time * 1E9 / gateTimes[r]; // entries in Time seconds
+	for ( int t = 0; t < Threads; t += 1 ) entries[r][t] = ( gateEnd[t] - gateBase[t] ) * scale + 0.5;
+#else
+	for ( int t = 0; t < Threads; t += 1 ) entries[r][t] = gateEnd[t] - gateBase[t];
+#endif // PRECISION
+} // gateResults
+
+static void gatePrint( unsigned int posn __attribute__(( unused )), const uint64_t totals[] __attribute__(( unused )) ) {
+#if defined( WORK )
+	uint64_t times[RUNS];								// nsec for WORK entries
+	for ( int r = 0; r < RUNS; r += 1 ) times[r] = (double)gateTimes[r] * WORK / workCounted[r];
+	qsort( times, RUNS, sizeof(typeof(times[0])), compare );
+	printf( "\nwork entries:%ju time(ms) median:%.3f min:%.3f max:%.3f rate:%.0f/sec", (uintmax_t)WORK,
+			median( times ) / 1E6, times[0] / 1E6, times[RUNS - 1] / 1E6, median( times ) == 0 ? 0.0 : WORK * 1E9 / median( times ) );
+#elif defined( WINDOW )
+	printf( "\nwindow warmup:%gms measured:%.3fms cooldown:%gms rate:%.0f/sec", windowMsec[0], gateTimes[posn] / 1E6,
+			windowMsec[2], gateTimes[posn] == 0 ? 0.0 : totals[posn] * 1E9 / gateTimes[posn] );
+#else
+	double mean = 0.0, m2 = 0.0, used = 0.0;			// over runs
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		double delta = totals[r] - mean;
+		mean += delta / ( r + 1 );
+		m2 += delta * ( totals[r] - mean );
+		used += gateTimes[r] / 1E9 + PRECISIONSLICE / 1E3;	// measured and warm-up
+	} // for
+	printf( "\nprecision target:+-%g%% run:+-%.2f%% slices:%u measured:%.3fs runs:+-%.2f%% time:%.1fs/%ds", (double)PRECISION,
+			precisionRun[posn] * 100.0, precisionSlices[posn], gateTimes[posn] / 1E9, precisionHalfWidth( RUNS, mean, m2 ) * 100.0,
+			used, RUNS * Time );
+#endif // WORK
+} // gatePrint
+
+#ifdef SWEEP
+static void gateReset() {								// next configuration, pool threads stopped
+	CurrRun = 0;
+	gateArrived = 0;
+	gateOpened = 0;
+} // gateReset
+#endif // SWEEP
+#endif // WORK || WINDOW || PRECISION
+
+// Called by every Worker after each critical-section passage.
+
+static inline void Passage( TYPE id __attribute__(( unused )) ) {
+	RmrMark( RmrDone );
+	TraceMark( id, TraceDone );
+#ifdef CYCLES
+	cyclesPassage();
+#endif // CYCLES
+#ifdef BREAKDOWN
+	uint64_t end = phaseStamp();						// before Passage delays
+#endif // BREAKDOWN
+#ifdef STRESSINTERVAL
+	PollBarrier();
+#endif // STRESSINTERVAL
+#ifdef PHASES
+	phaseCounts[id].cnt += 1;
+	while ( id >= PhaseLevel && stop == 0 ) cpuPause(); // idle in this phase ?
+#endif // PHASES
+#ifdef DELAY
+	delayPassage( id );
+#endif // DELAY
+#ifdef HANDOVER
+	while ( handoverHolder == id && stop == 0 ) cpuPause(); // alternate, wait for another thread to enter
+#endif // HANDOVER
+#ifdef BREAKDOWN
+	breakdownPassage( end );
+#endif // BREAKDOWN
+	RmrYield();											// interleave passages
+#if defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+	gatePassage();
+#endif // WORK || WINDOW || PRECISION
+	TraceArrival( id );
+} // Passage
+
+//------------------------------------------------------------------------------
+
+#ifdef HANDOVER
+static cpu_set_t handoverCPUs;							// process CPU set, e.g., from taskset
+#endif // HANDOVER
+
 void affinity( pthread_t pthreadid, unsigned int tid ) {
 // There are many ways to assign threads to processors: cores, chips, etc.
 // On the AMD, we find starting at core 32 and sequential assignment is sufficient.
 // Below are alternative approaches.
-#if defined( __linux ) && defined( PIN )
+#if defined( __linux ) && defined( HANDOVER )
+	cpu_set_t mask;										// round-robin over process CPU set
+	int cpu, cnt = CPU_COUNT( &handoverCPUs ), k = tid % cnt;
+	for ( cpu = 0; ! CPU_ISSET( cpu, &handoverCPUs ) || k-- > 0; cpu += 1 );
+	CPU_ZERO( &mask );
+	CPU_SET( cpu, &mask );
+	int rc = pthread_setaffinity_np( pthreadid, sizeof(cpu_set_t), &mask );
+	if ( rc != 0 ) {
+		errno = rc;
+		perror( "setaffinity" );
+		abort();
+	} // if
+#elif defined( __linux ) && defined( PIN )
 	cpu_set_t mask;
 
 	CPU_ZERO( &mask );
 	int cpu;
+	cpu_set_t process;									// process CPU set, e.g., from taskset or numactl
+	sched_getaffinity( 0, sizeof(process), &process );
+	if ( CPU_COUNT( &process ) < sysconf( _SC_NPROCESSORS_ONLN ) ) { // restricted, e.g., a partition by runpartition ?
+		int k = tid % CPU_COUNT( &process );			// round-robin over process CPU set
+		for ( cpu = 0; ! CPU_ISSET( cpu, &process ) || k-- > 0; cpu += 1 );
+	} else {
 #if 0
 	// 4x8x2 : 4 sockets, 8 cores per socket, 2 hyperthreads per core
 	cpu = (tid & 0x30) | ((tid & 1) << 3) | ((tid & 0xE) >> 1) + 32;
@@ -322,6 +1536,7 @@ void affinity( pthread_t pthreadid, unsigned int tid ) {
 #endif // FAST
 	cpu = tid + OFFSET;
 #endif // 0
+	} // if
 	//printf( "%d\n", cpu );
 	CPU_SET( cpu, &mask );
 	int rc = pthread_setaffinity_np( pthreadid, sizeof(cpu_set_t), &mask );
@@ -335,19 +1550,18 @@ void affinity( pthread_t pthreadid, unsigned int tid ) {
 
 //------------------------------------------------------------------------------
 
-static uint64_t **entries CALIGN;						// holds CS entry results for each threads for all runs
-
-#ifdef CNT
-struct cnts {
-	uint64_t cnt1, cnt2, cnt3;
-};
-static struct cnts **counters CALIGN;
-#endif // CNT
-
 #define xstr(s) str(s)
 #define str(s) #s
 #include xstr(Algorithm.c)								// include software algorithm for testing
 
+#if defined( CNT ) && ! defined( COUNTERS )
+#define COUNTERS( C )									// only built-in counters
+DeclareCounters( COUNTERS )
+#endif // CNT && ! COUNTERS
+#ifdef CNT
+_Static_assert( (int)NoCounters <= (int)MaxCounters, "too many counters" );
+#endif // CNT
+
 //------------------------------------------------------------------------------
 
 static void shuffle( unsigned int set[], const int size ) {
@@ -364,12 +1578,290 @@ static void shuffle( unsigned int set[], const int size ) {
 
 //------------------------------------------------------------------------------
 
-#define median(a) ((RUNS & 1) == 0 ? (a[RUNS/2-1] + a[RUNS/2]) / 2 : a[RUNS/2] )
-static int compare( const void *p1, const void *p2 ) {
-	size_t i = *((size_t *)p1);
-	size_t j = *((size_t *)p2);
-	return i > j ? 1 : i < j ? -1 : 0;
-} // compare
+// Run the RUNS experiments with the workers started, and print the median run's result.
+
+#ifndef STRESSINTERVAL
+static void runs() {
+	for ( int r = 0; r < RUNS; r += 1 ) {
+#if defined( PHASES )
+		phasesRun( r );									// schedule replaces Time
+#elif defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+		gateMeasure( r );								// work, window or adaptive run
+#else
+		//poll( NULL, 0, Time * 1000 );
+		sleep( Time );
+#endif // PHASES
+		stop = 1;										// reset
+#ifdef CNT
+		counterRedirect( RUNS );						// discard counts until next run
+#endif // CNT
+		while ( Arrived != Threads ) Pause();
+#if defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+		gateResults( r );								// replace workers' counts
+#endif // WORK || WINDOW || PRECISION
+#if defined( DELAY ) || defined( HANDOVER ) || defined( CYCLES ) || defined( BREAKDOWN ) || defined( TRACE ) || defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+		if ( r < RUNS - 1 ) CurrRun = r + 1;			// workers stopped, next run's samples
+#endif // DELAY || HANDOVER || CYCLES || BREAKDOWN || TRACE || WORK || WINDOW || PRECISION
+#ifdef HANDOVER
+		handoverTime = 0;								// no release in next run yet
+#endif // HANDOVER
+#ifdef CNT
+		if ( r < RUNS - 1 ) counterRedirect( r + 1 );	// run barrier, next run's counters
+#endif // CNT
+		stop = 0;
+		while ( Arrived != 0 ) Pause();
+	} // for
+} // runs
+#endif // ! STRESSINTERVAL
+
+static uint64_t results() {								// median entries
+	uint64_t totals[RUNS], sort[RUNS];
+
+#ifdef DEBUG
+	printf( "\n" );
+#endif // DEBUG
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		totals[r] = 0;
+		for ( int tid = 0; tid < Threads; tid += 1 ) {
+			totals[r] += entries[r][tid];
+#ifdef DEBUG
+			printf( "%ju ", entries[r][tid] );
+#endif // DEBUG
+		} // for
+#ifdef DEBUG
+		printf( "\n" );
+#endif // DEBUG
+		sort[r] = totals[r];
+	} // for
+	qsort( sort, RUNS, sizeof(typeof(sort[0])), compare );
+	uint64_t med = median( sort );
+	printf( "%ju", med );								// median round
+
+	unsigned int posn;									// run with median result
+	for ( posn = 0; posn < RUNS && totals[posn] != med; posn += 1 ); // assumes RUNS is odd
+#ifdef DEBUG
+	printf( "\ntotals: " );
+	for ( int i = 0; i < RUNS; i += 1 ) {				// print values
+		printf( "%ju ", totals[i] );
+	} // for
+	printf( "\nsorted: " );
+	for ( int i = 0; i < RUNS; i += 1 ) {				// print values
+		printf( "%ju ", sort[i] );
+	} // for
+	printf( "\nmedian posn:%d\n", posn );
+#endif // DEBUG
+	double avg = (double)totals[posn] / Threads;		// average
+	double sum = 0.0;
+	for ( int tid = 0; tid < Threads; tid += 1 ) {		// sum squared differences from average
+		double diff = entries[posn][tid] - avg;
+		sum += diff * diff;
+	} // for
+	double std = sqrt( sum / Threads );
+	printf( " %.1f %.1f %.1f%%", avg, std, avg == 0 ? 0.0 : std / avg * 100 );
+#if defined( TOTALS ) && ! defined( DEBUG )
+	printf( "\ntotals:" );								// runs, e.g., for tools/Compare.cc
+	for ( int r = 0; r < RUNS; r += 1 ) printf( " %ju", totals[r] );
+#endif // TOTALS && ! DEBUG
+#ifdef PHASES
+	phasesPrint();
+#endif // PHASES
+#ifdef DELAY
+	delayPrint( posn );
+#endif // DELAY
+#ifdef HANDOVER
+	handoverPrint( posn );
+#endif // HANDOVER
+#ifdef CYCLES
+	cyclesPrint( posn );
+#endif // CYCLES
+#ifdef BREAKDOWN
+	breakdownPrint( posn );
+#endif // BREAKDOWN
+#if defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+	gatePrint( posn, totals );
+#endif // WORK || WINDOW || PRECISION
+#ifdef RMR
+	rmrWrite( xstr(Algorithm), N );
+#endif // RMR
+#ifdef TRACE
+	traceWrite( xstr(Algorithm), N );
+#endif // TRACE
+
+#ifdef CNT
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		printf( "\ncounters run:%d%s entries:%ju", r, (unsigned int)r == posn ? "*" : "", totals[r] );
+		for ( int c = 0; c < NoCounters; c += 1 ) {
+			uint64_t sum = 0;
+			for ( int tid = 0; tid < Threads; tid += 1 ) sum += counters[( (size_t)r * Threads + tid ) * counterStride + c];
+			printf( " %s:%ju(%.3f/entry)", counterNames[c], sum, totals[r] == 0 ? 0.0 : (double)sum / totals[r] );
+		} // for
+	} // for
+#endif // CNT
+	printf( "\n" );
+	return med;
+} // results
+
+//------------------------------------------------------------------------------
+
+// In-process thread-count sweep.  With SWEEP, the first argument is a list of thread counts, "1,2,4,8", or a range,
+// "1-32", and each count is run as a separate experiment (RUNS x Time, one result line as without SWEEP), replacing the
+// relaunches of script run1.  The worker threads are created and pinned once, as a pool of the largest count, and the
+// threads beyond the current count sleep; each count calls the algorithm's ctor and dtor.  A range is measured on an
+// adaptive grid: first its ends and the powers of 2 between them, then, pass by pass, the midpoint of each pair of
+// adjacent measured counts whose median throughputs differ by more than SWEEPTOL percent (default 10), so points are
+// added only where the throughput curve changes sharply.  Result lines are printed as measured; "sort -n" orders them.
+// SWEEPTOL=0 measures every count in the range.  SWEEP measures throughput only, without the other modes.
+
+#ifdef SWEEP
+#if defined( STRESSINTERVAL ) || defined( PHASES ) || defined( DELAY ) || defined( HANDOVER ) || defined( CYCLES ) || defined( BREAKDOWN ) || defined( CNT ) || defined( RMR ) || defined( TRACE )
+	#error SWEEP measures throughput only, and is not combined with other modes except WORK, WINDOW and PRECISION
+#endif // STRESSINTERVAL || PHASES || DELAY || HANDOVER || CYCLES || BREAKDOWN || CNT || RMR || TRACE
+#ifndef SWEEPTOL
+#define SWEEPTOL 10										// percent
+#endif // ! SWEEPTOL
+
+enum { MaxSweep = 1024 };								// largest thread count
+static int sweepCounts[MaxSweep + 1], sweepNo, sweepMax, sweepRange; // list, or range ends, largest count
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t poolStart = PTHREAD_COND_INITIALIZER, poolDone = PTHREAD_COND_INITIALIZER;
+static unsigned int poolGen = 0, poolBusy = 0;			// experiment number, pool threads in experiment
+static unsigned int *poolSet;							// shuffled thread ids
+
+static void *Pool( void *arg ) {
+	int tid = (size_t)arg;
+	for ( unsigned int gen = 0;; ) {
+		pthread_mutex_lock( &poolLock );
+		while ( poolGen == gen ) pthread_cond_wait( &poolStart, &poolLock ); // sleep between experiments
+		gen = poolGen;
+		int threads = Threads;							// 0 => terminate
+		pthread_mutex_unlock( &poolLock );
+	  if ( threads == 0 ) break;
+	  if ( tid >= threads ) continue;					// idle in this experiment
+		Worker( (void *)(size_t)poolSet[tid] );
+		pthread_mutex_lock( &poolLock );
+		poolBusy -= 1;
+		if ( poolBusy == 0 ) pthread_cond_signal( &poolDone );
+		pthread_mutex_unlock( &poolLock );
+	} // for
+	return NULL;
+} // Pool
+
+static void poolStartup( int threads ) {				// Threads = threads, 0 => terminate pool
+	pthread_mutex_lock( &poolLock );
+	Threads = threads;
+	poolBusy = threads;
+	poolGen += 1;
+	pthread_cond_broadcast( &poolStart );
+	pthread_mutex_unlock( &poolLock );
+} // poolStartup
+
+static int sweepParse( const char *spec ) {				// false => bad spec
+	char *end;
+	sweepNo = sweepMax = sweepRange = 0;
+	for ( ;; ) {
+		long n = strtol( spec, &end, 10 );
+	  if ( end == spec || n < 1 || n > MaxSweep || sweepNo == MaxSweep ) return 0;
+		sweepCounts[sweepNo] = n;
+		sweepNo += 1;
+		if ( n > sweepMax ) sweepMax = n;
+	  if ( *end == '\0' ) break;
+		if ( *end == '-' && sweepNo == 1 ) sweepRange = 1;
+		else if ( *end != ',' || sweepRange ) return 0;
+		spec = end + 1;
+	} // for
+	return ! sweepRange || ( sweepNo == 2 && sweepCounts[0] < sweepCounts[1] );
+} // sweepParse
+
+static uint64_t sweepExperiment( int n ) {				// median entries for N = n
+	N = n;
+	printf( "%d %d ", N, Time );
+#ifdef FAST
+	assert( N <= MaxStartPoints );
+	NoStartPoints = MaxStartPoints / N * N;				// floor( MaxStartPoints / N )
+	startpoints( N );
+	const int threads = 1;
+#else
+	const int threads = N;
+#endif // FAST
+	for ( int i = 0; i < threads; i += 1 ) poolSet[ i ] = i;
+	Threads = threads;
+	shuffle( poolSet, threads );
+
+#if defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+	gateReset();
+#endif // WORK || WINDOW || PRECISION
+	ctor();												// global algorithm constructor
+	poolStartup( threads );
+	runs();
+	pthread_mutex_lock( &poolLock );
+	while ( poolBusy != 0 ) pthread_cond_wait( &poolDone, &poolLock ); // workers returned
+	pthread_mutex_unlock( &poolLock );
+	dtor();												// global algorithm destructor
+
+	uint64_t med = results();
+	fflush( stdout );
+	return med;
+} // sweepExperiment
+
+static void sweep() {
+#ifdef FAST
+	const int poolSize = 1;
+#else
+	const int poolSize = sweepMax;
+#endif // FAST
+	pthread_t pool[poolSize];
+	poolSet = malloc( sizeof(typeof(poolSet[0])) * poolSize );
+	for ( int tid = 0; tid < poolSize; tid += 1 ) {		// start pool
+		int rc = pthread_create( &pool[tid], NULL, Pool, (void *)(size_t)tid );
+		if ( rc != 0 ) {
+			errno = rc;
+			perror( "pthread create" );
+			abort();
+		} // if
+		affinity( pool[tid], tid );
+	} // for
+
+	if ( sweepRange ) {
+		const int lo = sweepCounts[0], hi = sweepCounts[1];
+		uint64_t med[hi + 1];
+		char measured[hi + 1];
+		memset( measured, 0, sizeof(measured) );
+		for ( int n = lo; n <= hi; ) {					// ends and powers of 2 between
+			med[n] = sweepExperiment( n );
+			measured[n] = 1;
+			int next;
+			for ( next = 1; next <= n; next *= 2 );
+			n = n == hi ? hi + 1 : next < hi ? next : hi;
+		} // for
+		for ( int refined = 1; refined; ) {				// pass over adjacent measured counts
+			refined = 0;
+			for ( int a = lo, b; a < hi; a = b ) {
+				for ( b = a + 1; ! measured[b]; b += 1 );
+				uint64_t diff = med[a] > med[b] ? med[a] - med[b] : med[b] - med[a];
+				uint64_t max = med[a] > med[b] ? med[a] : med[b];
+			  if ( b - a < 2 || diff * 100 <= (uint64_t)SWEEPTOL * max ) continue; // adjacent or similar ?
+				int mid = ( a + b ) / 2;
+				med[mid] = sweepExperiment( mid );
+				measured[mid] = 1;
+				refined = 1;
+			} // for
+		} // for
+	} else {
+		for ( int i = 0; i < sweepNo; i += 1 ) sweepExperiment( sweepCounts[i] );
+	} // if
+
+	poolStartup( 0 );									// terminate pool
+	for ( int tid = 0; tid < poolSize; tid += 1 ) {
+		int rc = pthread_join( pool[tid], NULL );
+		if ( rc != 0 ) {
+			errno = rc;
+			perror( "pthread join" );
+			abort();
+		} // if
+	} // for
+	free( poolSet );
+} // sweep
+#endif // SWEEP
 
 //------------------------------------------------------------------------------
 
@@ -383,38 +1875,82 @@ int main( int argc, char *argv[] ) {
 		if ( Degree < 2 ) goto usage;
 	  case 3:
 		Time = atoi( argv[2] );
+#ifdef SWEEP
+		if ( ! sweepParse( argv[1] ) ) goto usage;
+		N = sweepMax;
+#else
 		N = atoi( argv[1] );
+#endif // SWEEP
 		if ( Time < 1 || N < 1 ) goto usage;
 		break;
 	  usage:
 	  default:
+#ifdef SWEEP
+		printf( "Usage: %s 1,2,4,8 | 1-%d (list or adaptive range of numbers of threads) %d (time in seconds threads spend entering critical section) %d (Zhang D-ary)\n",
+				argv[0], N, Time, Degree );
+#else
 		printf( "Usage: %s %d (number of threads) %d (time in seconds threads spend entering critical section) %d (Zhang D-ary)\n",
 				argv[0], N, Time, Degree );
+#endif // SWEEP
 		exit( EXIT_FAILURE );
 	} // switch
 
-	printf( "%d %d ", N, Time );
-
 #ifdef FAST
 	assert( N <= MaxStartPoints );
 	Threads = 1;										// fast test, Threads=1, N=1..32
 	NoStartPoints = MaxStartPoints / N * N;				// floor( MaxStartPoints / N )
-	Startpoints = Allocator( sizeof(typeof(Startpoints[0])) * NoStartPoints );
-	startpoints( N );
+	Startpoints = Allocator( sizeof(typeof(Startpoints[0])) * MaxStartPoints );
 #else
-	Threads = N;										// allow testing of T < N
+	Threads = N;										// allow testing of T < N, largest with SWEEP
 	//N = 32;
 #endif // FAST
 	entries = malloc( sizeof(typeof(entries[0])) * RUNS );
 #ifdef CNT
-	counters = malloc( sizeof(typeof(counters[0])) * RUNS );
+	countSlot = &countDriver;							// driver
+	counterStride = ( NoCounters * sizeof(typeof(counters[0])) + CACHE_ALIGN - 1 ) / CACHE_ALIGN * CACHE_ALIGN / sizeof(typeof(counters[0]));
+	counters = Allocator( sizeof(typeof(counters[0])) * ( RUNS + 1 ) * Threads * counterStride );
+	memset( counters, 0, sizeof(typeof(counters[0])) * ( RUNS + 1 ) * Threads * counterStride );
+	counterSlots = Allocator( sizeof(typeof(counterSlots[0])) * Threads );
+	counterRedirect( 0 );
 #endif // CNT
 	for ( int r = 0; r < RUNS; r += 1 ) {
 		entries[r] = Allocator( sizeof(typeof(entries[0][0])) * Threads );
-#ifdef CNT
-		counters[r] = Allocator( sizeof(typeof(counters[0][0])) * Threads );
-#endif // CNT
 	} // for
+#if defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+	gateCtor( Threads );
+#endif // WORK || WINDOW || PRECISION
+
+#ifdef SWEEP
+	sweep();
+#else
+	printf( "%d %d ", N, Time );
+#ifdef FAST
+	startpoints( N );
+#endif // FAST
+
+#ifdef PHASES
+	phasesParse();
+#endif // PHASES
+#ifdef DELAY
+	delayParse();
+#endif // DELAY
+#ifdef CYCLES
+	cyclesCtor();
+#endif // CYCLES
+#ifdef BREAKDOWN
+	breakdownCtor( Threads );
+#endif // BREAKDOWN
+#ifdef RMR
+	rmrCtor( Threads );
+#endif // RMR
+#ifdef TRACE
+	traceCtor( Threads );
+#endif // TRACE
+#ifdef HANDOVER
+	handoverCtor();
+	CPU_ZERO( &handoverCPUs );
+	sched_getaffinity( 0, sizeof(handoverCPUs), &handoverCPUs );
+#endif // HANDOVER
 
 	unsigned int set[Threads];
 	for ( int i = 0; i < Threads; i += 1 ) set[ i ] = i;
@@ -448,14 +1984,7 @@ int main( int argc, char *argv[] ) {
 		BarHalt = 1; 
 	} // for
 #else
-	for ( int r = 0; r < RUNS; r += 1 ) {
-		//poll( NULL, 0, Time * 1000 );
-		sleep( Time );
-		stop = 1;										// reset
-		while ( Arrived != Threads ) Pause();
-		stop = 0;
-		while ( Arrived != 0 ) Pause();
-	} // for
+	runs();
 #endif // STRESSINTERVAL
 
 	for ( int tid = 0; tid < Threads; tid += 1 ) {		// terminate workers
@@ -469,63 +1998,17 @@ int main( int argc, char *argv[] ) {
 
 	dtor();												// global algorithm destructor
 
-	uint64_t totals[RUNS], sort[RUNS];
-
-#ifdef DEBUG
-	printf( "\n" );
-#endif // DEBUG
-	for ( int r = 0; r < RUNS; r += 1 ) {
-		totals[r] = 0;
-		for ( int tid = 0; tid < Threads; tid += 1 ) {
-			totals[r] += entries[r][tid];
-#ifdef DEBUG
-			printf( "%ju ", entries[r][tid] );
-#endif // DEBUG
-		} // for
-#ifdef DEBUG
-		printf( "\n" );
-#endif // DEBUG
-		sort[r] = totals[r];
-	} // for
-	qsort( sort, RUNS, sizeof(typeof(sort[0])), compare );
-	uint64_t med = median( sort );
-	printf( "%ju", med );								// median round
-
-	unsigned int posn;									// run with median result
-	for ( posn = 0; posn < RUNS && totals[posn] != med; posn += 1 ); // assumes RUNS is odd
-#ifdef DEBUG
-	printf( "\ntotals: " );
-	for ( int i = 0; i < RUNS; i += 1 ) {				// print values
-		printf( "%ju ", totals[i] );
-	} // for
-	printf( "\nsorted: " );
-	for ( int i = 0; i < RUNS; i += 1 ) {				// print values
-		printf( "%ju ", sort[i] );
-	} // for
-	printf( "\nmedian posn:%d\n", posn );
-#endif // DEBUG
-	double avg = (double)totals[posn] / Threads;		// average
-	double sum = 0.0;
-	for ( int tid = 0; tid < Threads; tid += 1 ) {		// sum squared differences from average
-		double diff = entries[posn][tid] - avg;
-		sum += diff * diff;
-	} // for
-	double std = sqrt( sum / Threads );
-	printf( " %.1f %.1f %.1f%%", avg, std, avg == 0 ? 0.0 : std / avg * 100 );
+	results();
+#endif // SWEEP
 
+#if defined( WORK ) || defined( WINDOW ) || defined( PRECISION )
+	gateDtor();
+#endif // WORK || WINDOW || PRECISION
 #ifdef CNT
-	uint64_t cnt1 = 0, cnt2 = 0, cnt3 = 0;
-	for ( int tid = 0; tid < Threads; tid += 1 ) {
-		cnt1 += counters[posn][tid].cnt1;
-		cnt2 += counters[posn][tid].cnt2;
-		cnt3 += counters[posn][tid].cnt3;
-	} // for
-	printf( "\ncnt1:%ju cnt2:%ju cnt3:%ju\n", cnt1, cnt2, cnt3 );
+	free( counterSlots );
+	free( counters );
 #endif // CNT
-
 	free( entries );
-
-	printf( "\n" );
 } // main
 
 // Local Variables: //
@@ -42,6 +42,7 @@ static void *Worker( void *arg ) {
 #endif // FLICKER
 			Q[id] = 0;									// exit protocol
 			entry += 1;
+			Passage( id );
 		} // while
 		entries[r][id] = entry;
 		__sync_fetch_and_add( &Arrived, 1 );
@@ -33,9 +33,7 @@ static void *Worker( void *arg ) {
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
-#ifdef STRESSINTERVAL
-			PollBarrier();
-#endif // STRESSINTERVAL
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -2,6 +2,49 @@
 
 volatile TYPE *choosing CALIGN, *ticket CALIGN;			// no "static" on SPARC
 
+static inline void entryProtocol( TYPE id ) {
+	// step 1, select a ticket
+	ST( choosing[id], 1 );								// entry protocol
+	Fence();											// force store before more loads
+	Delay( DelayDoorway );								// preempted while choosing
+	TYPE max = 0;										// O(N) search for largest ticket
+	for ( int j = 0; j < N; j += 1 ) {
+		TYPE v = LD( ticket[j] );						// could change so must copy
+		if ( max < v ) max = v;
+	} // for
+#if 1
+	max += 1;											// advance ticket
+	ST( ticket[id], max );
+	ST( choosing[id], 0 );
+	Fence();											// force store before more loads
+	DoorwayEnd();
+	Delay( DelayWaiter );								// preempted with ticket
+	// step 2, wait for ticket to be selected
+	for ( int j = 0; j < N; j += 1 ) {					// check other tickets
+		while ( LD( choosing[j] ) == 1 ) Pause();		// busy wait if thread selecting ticket
+		while ( LD( ticket[j] ) != 0 &&					// busy wait if choosing or
+				( LD( ticket[j] ) < max ||				//  greater ticket value or lower priority
+				( LD( ticket[j] ) == max && j < id ) ) ) Pause();
+	} // for
+#else
+	ticket[id] = max + 1;								// advance ticket
+	choosing[id] = 0;
+	Fence();											// force store before more loads
+	// step 2, wait for ticket to be selected
+	for ( int j = 0; j < N; j += 1 ) {					// check other tickets
+		while ( choosing[j] == 1 ) Pause();				// busy wait if thread selecting ticket
+		while ( ticket[j] != 0 &&						// busy wait if choosing or
+				( ticket[j] < ticket[id] ||				//  greater ticket value or lower priority
+				( ticket[j] == ticket[id] && j < id ) ) ) Pause();
+	} // for
+#endif
+} // entryProtocol
+
+static inline void exitProtocol( TYPE id ) {
+	ST( ticket[id], 0 );								// exit protocol
+} // exitProtocol
+
+#ifndef NOWORKER
 static void *Worker( void *arg ) {
 	TYPE id = (size_t)arg;
 	uint64_t entry;
@@ -12,45 +55,15 @@ static void *Worker( void *arg ) {
 	for ( int r = 0; r < RUNS; r += 1 ) {
 		entry = 0;
 		while ( stop == 0 ) {
-			// step 1, select a ticket
-			choosing[id] = 1;							// entry protocol
-			Fence();									// force store before more loads
-			TYPE max = 0;								// O(N) search for largest ticket
-			for ( int j = 0; j < N; j += 1 ) {
-				TYPE v = ticket[j];						// could change so must copy
-				if ( max < v ) max = v;
-			} // for
-#if 1
-			max += 1;									// advance ticket
-			ticket[id] = max;
-			choosing[id] = 0;
-			Fence();									// force store before more loads
-			// step 2, wait for ticket to be selected
-			for ( int j = 0; j < N; j += 1 ) {			// check other tickets
-				while ( choosing[j] == 1 ) Pause();		// busy wait if thread selecting ticket
-				while ( ticket[j] != 0 &&				// busy wait if choosing or
-						( ticket[j] < max ||			//  greater ticket value or lower priority
-						( ticket[j] == max && j < id ) ) ) Pause();
-			} // for
-#else
-			ticket[id] = max + 1;						// advance ticket
-			choosing[id] = 0;
-			Fence();									// force store before more loads
-			// step 2, wait for ticket to be selected
-			for ( int j = 0; j < N; j += 1 ) {			// check other tickets
-				while ( choosing[j] == 1 ) Pause();		// busy wait if thread selecting ticket
-				while ( ticket[j] != 0 &&				// busy wait if choosing or
-						( ticket[j] < ticket[id] ||		//  greater ticket value or lower priority
-						( ticket[j] == ticket[id] && j < id ) ) ) Pause();
-			} // for
-#endif
+			entryProtocol( id );
 			CriticalSection( id );
-			ticket[id] = 0;								// exit protocol
+			exitProtocol( id );
 #ifdef FAST
 			id = startpoint( cnt );						// different starting point each experiment
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -62,6 +75,7 @@ static void *Worker( void *arg ) {
 	} // for
 	return NULL;
 } // Worker
+#endif // ! NOWORKER
 
 void ctor() {
 	choosing = Allocator( sizeof(typeof(choosing[0])) * N );
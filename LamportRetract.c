@@ -3,6 +3,10 @@
 
 enum Intent { DontWantIn, WantIn };
 
+// With CNT, retract counts restarts at L after retracting for a higher-priority thread.
+#define COUNTERS( C ) C( retract )
+DeclareCounters( COUNTERS )
+
 static volatile TYPE *intents CALIGN;					// shared
 
 static void *Worker( void *arg ) {
@@ -23,6 +27,7 @@ static void *Worker( void *arg ) {
 					intents[id] = DontWantIn;
 					Fence();							// force store before more loads
 					while ( intents[j] == WantIn ) Pause();
+					Count( retract );
 					goto L;
 				} // if
 			} // for
@@ -35,6 +40,7 @@ static void *Worker( void *arg ) {
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -6,6 +6,28 @@ static int depth, width, mask;
 
 static inline TYPE min( TYPE a, TYPE b ) { return a < b ? a : b; }
 
+static inline void entryProtocol( TYPE id ) {
+	unsigned int lid, comp, role, low, high;
+
+	for ( TYPE km1 = 0, k = 1; k <= depth; km1 += 1, k += 1 ) { // entry protocol
+		lid = id >> km1;								// local id
+		comp = (lid >> 1) + (width >> k);				// unique position in the tree
+		role = lid & 1;									// left or right descendent
+		intents[id] = k;								// declare intent, current round
+		turns[comp] = role;								// RACE
+		Fence();										// force store before more loads
+		low = ((lid) ^ 1) << km1;						// lower competition
+		high = min( low | mask >> (depth - km1), N - 1 ); // higher competition
+		for ( int i = low; i <= high; i += 1 )			// busy wait
+			while ( intents[i] >= k && turns[comp] == role ) Pause();
+	} // for
+} // entryProtocol
+
+static inline void exitProtocol( TYPE id ) {
+	intents[id] = 0;									// exit protocol
+} // exitProtocol
+
+#ifndef NOWORKER
 static void *Worker( void *arg ) {
 	TYPE id = (size_t)arg;
 	uint64_t entry;
@@ -13,30 +35,18 @@ static void *Worker( void *arg ) {
 	unsigned int cnt = 0, oid = id;
 #endif // FAST
 
-	unsigned int lid, comp, role, low, high;
-
 	for ( int r = 0; r < RUNS; r += 1 ) {
 		entry = 0;
 		while ( stop == 0 ) {
-			for ( TYPE km1 = 0, k = 1; k <= depth; km1 += 1, k += 1 ) { // entry protocol
-				lid = id >> km1;						// local id
-				comp = (lid >> 1) + (width >> k);		// unique position in the tree
-				role = lid & 1;							// left or right descendent
-				intents[id] = k;						// declare intent, current round
-				turns[comp] = role;						// RACE
-				Fence();								// force store before more loads
-				low = ((lid) ^ 1) << km1;				// lower competition
-				high = min( low | mask >> (depth - km1), N - 1 ); // higher competition
-				for ( int i = low; i <= high; i += 1 )	// busy wait
-					while ( intents[i] >= k && turns[comp] == role ) Pause();
-			} // for
+			entryProtocol( id );
 			CriticalSection( id );
-			intents[id] = 0;							// exit protocol
+			exitProtocol( id );
 #ifdef FAST
 			id = startpoint( cnt );						// different starting point each experiment
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -48,6 +58,7 @@ static void *Worker( void *arg ) {
 	} // for
 	return NULL;
 } // Worker
+#endif // ! NOWORKER
 
 void ctor() {
 	depth = Clog2( N );									// maximal depth of binary tree
@@ -9,34 +9,46 @@ typedef struct CALIGN mcs_node {
 
 void mcs_lock( MCS_lock *lock, MCS_node *node ) {
 	MCS_node *pred;
-	node->next = NULL;
+	ST( node->next, NULL );
 #if defined( __sparc )
 	pred = SWAP32( lock, node );						// fetch-and-store
 #else
-	pred = __sync_lock_test_and_set( lock, node );		// fetch-and-store
+	pred = __sync_lock_test_and_set( RMW( *lock ), node ); // fetch-and-store
 #endif
 	if ( FASTPATH( pred != NULL ) ) {					// someone on list ?
-		node->spin = 1;									// mark as waiting
-		pred->next = node;								// add to list of waiting threads
-		while ( node->spin == 1 ) Pause();				// busy wait on my spin variable
+		ST( node->spin, 1 );							// mark as waiting
+		ST( pred->next, node );							// add to list of waiting threads
+		DoorwayEnd();
+		Delay( DelayWaiter );							// preempted waiter
+		while ( LD( node->spin ) == 1 ) Pause();		// busy wait on my spin variable
 	} // if
 } // mcs_lock
 
 void mcs_unlock( MCS_lock *lock, MCS_node *node ) {
-	if ( node->next == NULL ) {							// no one waiting ?
+	if ( LD( node->next ) == NULL ) {					// no one waiting ?
 #if defined( __sparc )
   if ( (void *)CAS32( lock, node, NULL ) == node ) return; // not changed since last looked ?
 #else
-  if ( __sync_bool_compare_and_swap( lock, node, NULL ) ) return; // not changed since last looked ?
+  if ( __sync_bool_compare_and_swap( RMW( *lock ), node, NULL ) ) return; // not changed since last looked ?
 #endif
-		while ( node->next == NULL ) Pause();			// busy wait until my node is modified
+		while ( LD( node->next ) == NULL ) Pause();		// busy wait until my node is modified
 	} // if
-	node->next->spin = 0;								// stop their busy wait
+	ST( LD( node->next )->spin, 0 );					// stop their busy wait
 } // mcs_unlock
 
 static MCS_lock lock CALIGN;
+static MCS_node *nodes CALIGN;							// queue node for each thread
 static TYPE PAD CALIGN __attribute__(( unused ));		// protect further false sharing
 
+static inline void entryProtocol( TYPE id ) {
+	mcs_lock( &lock, &nodes[id] );
+} // entryProtocol
+
+static inline void exitProtocol( TYPE id ) {
+	mcs_unlock( &lock, &nodes[id] );
+} // exitProtocol
+
+#ifndef NOWORKER
 static void *Worker( void *arg ) {
 	TYPE id = (size_t)arg;
 	uint64_t entry;
@@ -44,19 +56,18 @@ static void *Worker( void *arg ) {
 	unsigned int cnt = 0, oid = id;
 #endif // FAST
 
-	MCS_node node CALIGN;
-
 	for ( int r = 0; r < RUNS; r += 1 ) {
 		entry = 0;
 		while ( stop == 0 ) {
-			mcs_lock( &lock, &node );
+			entryProtocol( id );
 			CriticalSection( id );
-			mcs_unlock( &lock, &node );
+			exitProtocol( id );
 #ifdef FAST
 			id = startpoint( cnt );						// different starting point each experiment
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -68,12 +79,15 @@ static void *Worker( void *arg ) {
 	} // for
 	return NULL;
 } // Worker
+#endif // ! NOWORKER
 
 void ctor() {
 	lock = NULL;
+	nodes = Allocator( sizeof(typeof(nodes[0])) * N );
 } // ctor
 
 void dtor() {
+	free( nodes );
 } // dtor
 
 // Local Variables: //
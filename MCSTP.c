@@ -0,0 +1,127 @@
+// Bijun He, William N. Scherer III and Michael L. Scott, Preemption Adaptivity in Time-Published Queue-Based Spin
+// Locks, HiPC 2005, LNCS 3769, p. 7
+//
+// MCS queue lock tolerating preempted waiters.  A waiter publishes a timestamp in its queue node while spinning, and
+// the releasing thread grants the lock to the first successor whose timestamp is recent (less than STALE timestamp
+// units, cycles on x86); a successor with a stale timestamp is presumed descheduled, marked Removed, and skipped.  A
+// skipped node is returned to its owner (Retry) once the releaser has read its next link, and the owner re-enqueues,
+// so the releaser grants the successor it read and never rereads a returned node.
+// Unlike the paper, a releaser does not splice removed nodes out of the queue; it walks past them, so a skipped
+// waiter rejoins at the tail.  With CNT, counter skipped counts re-enqueues after being skipped.
+
+#ifndef STALE
+#define STALE 100000									// timestamp units, x86 cycles
+#endif // ! STALE
+
+enum { Granted, Waiting, Removed, Retry };
+
+#define COUNTERS( C ) C( skipped )
+DeclareCounters( COUNTERS )
+
+static inline uint64_t tstamp() {
+#if defined( __i386 ) || defined( __x86_64 )
+	uint32_t lo, hi;
+	__asm__ __volatile__ ( "rdtsc" : "=a" (lo), "=d" (hi) );
+	return (uint64_t)hi << 32 | lo;
+#else
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+} // tstamp
+
+typedef struct mcstp_node MCSTP_node;
+typedef struct CALIGN mcstp_node {
+	MCSTP_node *volatile next;
+	volatile TYPE spin;
+	volatile uint64_t time;								// published while waiting
+} *MCSTP_lock;
+
+static inline void mcstp_lock( MCSTP_lock *lock, MCSTP_node *node ) {
+	for ( ;; ) {
+		MCSTP_node *pred;
+		node->next = NULL;
+		node->spin = Waiting;
+		node->time = tstamp();
+		pred = __sync_lock_test_and_set( lock, node );	// fetch-and-store
+	  if ( FASTPATH( pred == NULL ) ) break;			// no one on list ?
+		pred->next = node;								// add to list of waiting threads
+		DoorwayEnd();
+		Delay( DelayWaiter );							// preempted waiter
+		while ( node->spin == Waiting ) {				// busy wait on my spin variable
+			node->time = tstamp();						// publish liveness
+			Pause();
+		} // while
+	  if ( FASTPATH( node->spin == Granted ) ) break;
+		while ( node->spin != Retry ) Pause();			// releaser still reading my next link
+		Count( skipped );
+	} // for
+} // mcstp_lock
+
+static inline void mcstp_unlock( MCSTP_lock *lock, MCSTP_node *node ) {
+	MCSTP_node *own = node, *succ;
+	for ( ;; ) {
+		succ = node->next;
+		if ( succ == NULL ) {							// no one waiting ?
+			if ( __sync_bool_compare_and_swap( lock, node, NULL ) ) { // not changed since last looked ?
+				if ( node != own ) node->spin = Retry;	// return skipped tail
+				return;
+			} // if
+			while ( (succ = node->next) == NULL ) Pause(); // busy wait until my node is modified
+		} // if
+		if ( node != own ) node->spin = Retry;			// next link read, return skipped node
+	  if ( FASTPATH( tstamp() - succ->time < STALE ) ) break; // successor running ?
+		succ->spin = Removed;							// skip preempted successor
+		node = succ;
+	} // for
+	succ->spin = Granted;								// stop their busy wait, node may be re-enqueued
+} // mcstp_unlock
+
+static MCSTP_lock lock CALIGN;
+static MCSTP_node *nodes CALIGN;						// queue node for each thread
+static TYPE PAD CALIGN __attribute__(( unused ));		// protect further false sharing
+
+static void *Worker( void *arg ) {
+	TYPE id = (size_t)arg;
+	uint64_t entry;
+#ifdef FAST
+	unsigned int cnt = 0, oid = id;
+#endif // FAST
+
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		entry = 0;
+		while ( stop == 0 ) {
+			mcstp_lock( &lock, &nodes[id] );
+			CriticalSection( id );
+			mcstp_unlock( &lock, &nodes[id] );
+#ifdef FAST
+			id = startpoint( cnt );						// different starting point each experiment
+			cnt = cycleUp( cnt, NoStartPoints );
+#endif // FAST
+			entry += 1;
+			Passage( id );
+		} // while
+#ifdef FAST
+		id = oid;
+#endif // FAST
+		entries[r][id] = entry;
+		__sync_fetch_and_add( &Arrived, 1 );
+		while ( stop != 0 ) Pause();
+		__sync_fetch_and_add( &Arrived, -1 );
+	} // for
+	return NULL;
+} // Worker
+
+void ctor() {
+	lock = NULL;
+	nodes = Allocator( sizeof(typeof(nodes[0])) * N );
+} // ctor
+
+void dtor() {
+	free( nodes );
+} // dtor
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-command: "gcc -Wall -std=gnu11 -O3 -DNDEBUG -fno-reorder-functions -DPIN -DAlgorithm=MCSTP Harness.c -lpthread -lm" //
+// End: //
@@ -3,8 +3,26 @@
 
 static volatile TYPE *Q CALIGN, *turns CALIGN;
 
+static inline void entryProtocol( TYPE id ) {
+	id += 1;											// id 0 => don't-want-in
+	for ( TYPE rd = 1; rd < N; rd += 1 ) {				// entry protocol, round
+		Q[id] = rd;										// current round
+		turns[rd] = id;									// RACE
+		Fence();										// force store before more loads
+	  L: for ( int k = 1; k <= N; k += 1 ) {			// find loser
+//			if ( k != id && Q[k] == rd ) cnt[rd] += 1;
+			if ( k != id && Q[k] >= rd && turns[rd] == id ) { Pause(); goto L; }
+		} // for
+	} // for
+} // entryProtocol
+
+static inline void exitProtocol( TYPE id ) {
+	Q[id + 1] = 0;										// exit protocol
+} // exitProtocol
+
+#ifndef NOWORKER
 static void *Worker( void *arg ) {
-	TYPE id = (size_t)arg + 1;					// id 0 => don't-want-in
+	TYPE id = (size_t)arg;
 	uint64_t entry;
 #ifdef FAST
 	unsigned int cnt = 0, oid = id;
@@ -16,27 +34,20 @@ static void *Worker( void *arg ) {
 		entry = 0;
 //		for ( int i = 1; i < N; i += 1 ) cnt[i] = 0;
 		while ( stop == 0 ) {
-			for ( TYPE rd = 1; rd < N; rd += 1 ) {		// entry protocol, round
-				Q[id] = rd;								// current round
-				turns[rd] = id;							// RACE
-				Fence();								// force store before more loads
-			  L: for ( int k = 1; k <= N; k += 1 ) {		// find loser
-//					if ( k != id && Q[k] == rd ) cnt[rd] += 1;
-					if ( k != id && Q[k] >= rd && turns[rd] == id ) { Pause(); goto L; }
-				} // for
-			} // for
+			entryProtocol( id );
 			CriticalSection( id );
-			Q[id] = 0;									// exit protocol
+			exitProtocol( id );
 #ifdef FAST
 			id = startpoint( cnt );						// different starting point each experiment
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
 #endif // FAST
-		entries[r][id - 1] = entry;						// adjust for id + 1
+		entries[r][id] = entry;
 		__sync_fetch_and_add( &Arrived, 1 );
 		while ( stop != 0 ) Pause();
 		__sync_fetch_and_add( &Arrived, -1 );
@@ -45,6 +56,7 @@ static void *Worker( void *arg ) {
 	} // for
 	return NULL;
 } // Worker
+#endif // ! NOWORKER
 
 void ctor() {
 	Q = Allocator( sizeof(typeof(Q[0])) * (N + 1) );
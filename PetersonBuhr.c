@@ -43,6 +43,7 @@ static void *Worker( void *arg ) {
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -70,7 +71,7 @@ void __attribute__((noinline)) ctor() {
 	for ( int id = 0; id < N; id += 1 ) {
 		t[id].Q[0] = t[id].Q[1] = 0;
 #if defined( KESSELS2 )
-		t[id].R[0] = t[id].R[1] = 0;
+		t[id].K[0] = t[id].K[1] = 0;
 #else
 		t[id].R = 0;
 #endif // KESSELS2
@@ -11,6 +11,7 @@ static void *Worker( void *arg ) {
 			CriticalSection( id );
 			pthread_mutex_unlock( &lock );
 			entry += 1;
+			Passage( id );
 		} // while
 		entries[r][id] = entry;
 		__sync_fetch_and_add( &Arrived, 1 );
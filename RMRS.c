@@ -17,27 +17,27 @@ typedef struct CALIGN {
 static int toursize CALIGN;
 
 static inline bool QnotEmpty( volatile Queue *queue ) {
-	return queue->front != queue->rear;
+	return LD( queue->front ) != LD( queue->rear );
 } // QnotEmpty
 
 static inline void Qenqueue( volatile Queue *queue, QElem_t element ) {
-	if ( FASTPATH( element != FREE_NODE && queue->inQueue[element] == false ) ) {
-		queue->elements[queue->rear] = element;
-		queue->rear = cycleUp( queue->rear, queue->capacity );
+	if ( FASTPATH( element != FREE_NODE && LD( queue->inQueue[element] ) == false ) ) {
+		ST( queue->elements[LD( queue->rear )], element );
+		ST( queue->rear, cycleUp( LD( queue->rear ), queue->capacity ) );
 //		queue->rear += 1;
 //		if ( queue->rear == queue->capacity )
 //			queue->rear=0; 		
-		queue->inQueue[element] = true;
+		ST( queue->inQueue[element], true );
 	} // if
 } // Qenqueue
 
 static inline QElem_t Qdequeue( volatile Queue *queue ) {
-	QElem_t element = queue->elements[queue->front];
-	queue->front = cycleUp( queue->front, queue->capacity );
+	QElem_t element = LD( queue->elements[LD( queue->front )] );
+	ST( queue->front, cycleUp( LD( queue->front ), queue->capacity ) );
 //	queue->front += 1;
 //	if ( queue->front == queue->capacity )
 //		queue->front = 0;
-	queue->inQueue[element] = false;
+	ST( queue->inQueue[element], false );
 	return element;
 } // Qdequeue
 
@@ -90,32 +90,34 @@ static void *Worker( void *arg ) {
 	for ( int r = 0; r < RUNS; r += 1 ) {
 		entry = 0;
 		while ( stop == 0 ) {
-			*tEnter = true;
+			ST( *tEnter, true );
 
 			// up hill
 			typeof(id) node = id;
 			for ( int j = 0; j < toursize; j += 1 ) {	// tree register
-				tournament[j][node] = id;
+				ST( tournament[j][node], id );
 				node >>= 1;
 			} // for
+			DoorwayEnd();
 
-			if ( FASTPATH( ! __sync_bool_compare_and_swap( &first, FREE_LOCK, id ) ) ) {
-				typeof(exits) e = exits;
-				await( exits - e >= 2 || first == FREE_LOCK || first == id );
-				if ( FASTPATH( ! __sync_bool_compare_and_swap( &first, FREE_LOCK, id ) ) ) {
-					await( *tWait );
+			if ( FASTPATH( ! __sync_bool_compare_and_swap( RMW( first ), FREE_LOCK, id ) ) ) {
+				typeof(exits) e = LD( exits );
+				await( LD( exits ) - e >= 2 || LD( first ) == FREE_LOCK || LD( first ) == id );
+				if ( FASTPATH( ! __sync_bool_compare_and_swap( RMW( first ), FREE_LOCK, id ) ) ) {
+					await( LD( *tWait ) );
 				} // if
 			} // if
 
-			*tEnter = *tWait = false;
-			exits += 1 ;
+			ST( *tWait, false );
+			ST( *tEnter, false );
+			ST( exits, LD( exits ) + 1 );
 			//Fence();									// force store before more loads
 
 			CriticalSection( id );
 
 			// down hill
-			TYPE thread = tournament[toursize - 1][0];
-			if ( FASTPATH( thread != FREE_NODE && thread != id && arrState[thread].enter ) )
+			TYPE thread = LD( tournament[toursize - 1][0] );
+			if ( FASTPATH( thread != FREE_NODE && thread != id && LD( arrState[thread].enter ) ) )
 				Qenqueue( q, thread );
 
 			for ( int j = toursize - 2; j >= 0; j -= 1 ) {
@@ -124,27 +126,28 @@ static void *Worker( void *arg ) {
 				if ( node & 1 ) {
 					node -= 1;
 				} // if
-				thread = tournament[j][node];
-				if ( thread != FREE_NODE && thread != id && arrState[thread].enter ) {
+				thread = LD( tournament[j][node] );
+				if ( thread != FREE_NODE && thread != id && LD( arrState[thread].enter ) ) {
 					Qenqueue( q, thread );
 				} // if
-				thread = tournament[j][node + 1];
-				if ( thread != FREE_NODE && thread != id && arrState[thread].enter ) {
+				thread = LD( tournament[j][node + 1] );
+				if ( thread != FREE_NODE && thread != id && LD( arrState[thread].enter ) ) {
 					Qenqueue( q, thread );
 				} // if
 			} // for
 			if ( FASTPATH( QnotEmpty( q ) ) ) {
 				thread = Qdequeue( q );
-				first = thread;
-				arrState[thread].wait = true;
+				ST( first, thread );
+				ST( arrState[thread].wait, true );
 			} else {
-				first = FREE_LOCK;
+				ST( first, FREE_LOCK );
 			} // if
 #ifdef FAST
 			id = startpoint( cnt );						// different starting point each experiment
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
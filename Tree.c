@@ -0,0 +1,285 @@
+// Generic d-ary tournament tree shared by the tree algorithms.  The N threads are the leaves of a tree of arity
+// Degree, where a level with M contenders has ceil(M / Degree) nodes.  A node with a single contender is elided
+// because no match is necessary, so node storage is sized to the matches actually played.  Each thread's leaf-to-root
+// path of (node, position, width) steps is computed once by tree_ctor, so a passage only walks a private array rather
+// than recomputing logarithms, powers and row indexes.
+//
+// The node (match) algorithm is selected at compile time:
+//   ZHANG     d-thread node from Zhang, Yan and Castaneda, any Degree >= 2
+//   default   2-thread node from Binary.c, Degree must be 2 (node algorithm selected by -DDEKKERRW, -DTSAY, etc.)
+//   MIXED     2-thread node from Binary.c chosen per tree level, e.g., -DMIXED='"DEKKERRW TSAY"' (see below)
+//
+// The placement of 2-thread nodes in memory is also selected at compile time:
+//   default   level order, each token padded to its own cache line
+//   PACKED    level order, unpadded tokens packed into lines (like the per-level rows of Taubenfeld)
+//   VEB       van Emde Boas order, unpadded tokens, so a root path crosses O(log N / log B) lines
+//   LEAFPAIR  each leaf match in a line touched only by its two threads, inner matches packed in van Emde Boas order
+// Packed tokens never straddle a cache line.
+
+#if defined( ZHANG ) && defined( MIXED )
+	#error MIXED selects 2-thread nodes, which is incompatible with ZHANG
+#endif // ZHANG && MIXED
+
+#ifdef ZHANG
+
+typedef TYPE Node;										// Degree intent flags per node
+enum { NodeStride = 0 };								// stride is Degree words
+
+#else
+
+#if defined( PACKED ) || defined( VEB ) || defined( LEAFPAIR )
+#define PACKTOKEN
+#endif // PACKED || VEB || LEAFPAIR
+#include "Binary.c"
+
+typedef Token Node;
+enum { NodeStride = 1 };								// one token per node
+
+#endif // ZHANG
+
+typedef struct {
+	volatile Node *ns;									// pointer to match data
+	unsigned int es;									// position of contender within match
+#ifdef ZHANG
+	unsigned int ws;									// number of contenders at match
+#endif // ZHANG
+#ifdef MIXED
+	unsigned int as;									// 2-thread algorithm at match
+#endif // MIXED
+} Path;
+
+#ifdef ZHANG
+
+static inline void node_prologue( const Path *p ) {
+	volatile Node *x = p->ns;
+	const unsigned int es = p->es;
+  L: x[es] = 1;											// declare intent
+	Fence();											// force store before more loads
+	for ( unsigned int i = 0; i < es; i += 1 ) {		// higher priority contender ?
+		if ( x[i] ) {
+			x[es] = 0;									// retract intent
+			Fence();									// force store before more loads
+			while ( x[i] != 0 ) Pause();
+			goto L;
+		} // if
+	} // for
+	for ( unsigned int i = es + 1; i < p->ws; i += 1 )	// wait for lower priority contenders to leave
+		while ( x[i] ) Pause();
+} // node_prologue
+
+static inline void node_epilogue( const Path *p ) {
+	p->ns[p->es] = 0;
+} // node_epilogue
+
+static inline void node_ctor( volatile Node *x, unsigned int degree ) {
+	for ( unsigned int i = 0; i < degree; i += 1 ) x[i] = 0;
+} // node_ctor
+
+#elif defined( MIXED )
+
+#include <string.h>										// strtok_r, strcmp
+
+// MIXED is a string naming the 2-thread algorithm of each tree level from the root down, e.g., "DEKKERRW TSAY", where
+// the last name is repeated for the remaining levels to the leaves.
+enum { Peterson, DekkerOrig, DekkerA, DekkerB, Doran, DekkerRW, Tsay, Kessels2, NoBinaries };
+static const char *binaries[NoBinaries] = { "PETERSON", "DEKKERORIG", "DEKKERA", "DEKKERB", "DORAN", "DEKKERRW", "TSAY", "KESSELS2" };
+
+static inline void node_prologue( const Path *p ) {
+	switch ( p->as ) {
+	  case Peterson: peterson_prologue( p->es, p->ns ); break;
+	  case DekkerOrig: dekkerorig_prologue( p->es, p->ns ); break;
+	  case DekkerA: dekkera_prologue( p->es, p->ns ); break;
+	  case DekkerB: dekkerb_prologue( p->es, p->ns ); break;
+	  case Doran: doran_prologue( p->es, p->ns ); break;
+	  case DekkerRW: dekkerrw_prologue( p->es, p->ns ); break;
+	  case Tsay: tsay_prologue( p->es, p->ns ); break;
+	  case Kessels2: kessels2_prologue( p->es, p->ns ); break;
+	} // switch
+} // node_prologue
+
+static inline void node_epilogue( const Path *p ) {
+	switch ( p->as ) {
+	  case Peterson: peterson_epilogue( p->es, p->ns ); break;
+	  case DekkerOrig: case DekkerA: case DekkerB: case Doran: dekker_epilogue( p->es, p->ns ); break;
+	  case DekkerRW: dekkerrw_epilogue( p->es, p->ns ); break;
+	  case Tsay: tsay_epilogue( p->es, p->ns ); break;
+	  case Kessels2: kessels2_epilogue( p->es, p->ns ); break;
+	} // switch
+} // node_epilogue
+
+static inline void node_ctor( volatile Node *t, unsigned int degree __attribute__(( unused )) ) {
+	t->Q[0] = t->Q[1] = t->R = 0;
+	t->K[0] = t->K[1] = 0;
+} // node_ctor
+
+static void mixed( unsigned int depth, unsigned int algs[] ) { // parse MIXED into algs indexed by level, leaves 0
+	char spec[] = MIXED, *save, *name = strtok_r( spec, " ,", &save );
+	unsigned int alg = Peterson;
+	for ( int j = depth - 1; j >= 0; j -= 1 ) {			// root down
+		if ( name != NULL ) {
+			for ( alg = 0; alg < NoBinaries && strcmp( name, binaries[alg] ) != 0; alg += 1 );
+			if ( alg == NoBinaries ) {
+				printf( "Usage: unknown 2-thread algorithm %s in MIXED.\n", name );
+				exit( EXIT_FAILURE );
+			} // if
+			name = strtok_r( NULL, " ,", &save );
+		} // if
+		algs[j] = alg;
+	} // for
+} // mixed
+
+#else
+
+static inline void node_prologue( const Path *p ) {
+	binary_prologue( p->es, p->ns );
+} // node_prologue
+
+static inline void node_epilogue( const Path *p ) {
+	binary_epilogue( p->es, p->ns );
+} // node_epilogue
+
+static inline void node_ctor( volatile Node *t, unsigned int degree __attribute__(( unused )) ) {
+	t->Q[0] = t->Q[1] = 0;
+#if defined( KESSELS2 )
+	t->K[0] = t->K[1] = 0;
+#else
+	t->R = 0;
+#endif // KESSELS2
+} // node_ctor
+
+#endif // ZHANG
+
+//------------------------------------------------------------------------------
+
+static Path **paths CALIGN;								// leaf-to-root path for each thread
+static unsigned int *heights CALIGN;					// number of matches on each path
+static char *nodes CALIGN;								// storage for all matches
+static unsigned int depth CALIGN;						// maximal height of tree
+
+static inline void tree_entry( TYPE id ) {
+	const Path *path = paths[id];
+	const unsigned int height = heights[id];
+	for ( unsigned int s = 0; s < height; s += 1 ) {	// entry protocol, leaf to root
+		node_prologue( &path[s] );
+	} // for
+} // tree_entry
+
+static inline void tree_exit( TYPE id ) {
+	const Path *path = paths[id];
+	for ( int s = heights[id] - 1; s >= 0; s -= 1 ) {	// exit protocol, retract reverse order
+		node_epilogue( &path[s] );
+	} // for
+} // tree_exit
+
+static inline size_t tree_place( size_t *top, size_t size ) { // next node offset, without straddling a cache line
+	if ( *top % CACHE_ALIGN + size > CACHE_ALIGN ) *top = (*top + CACHE_ALIGN - 1) / CACHE_ALIGN * CACHE_ALIGN;
+	size_t offset = *top;
+	*top += size;
+	return offset;
+} // tree_place
+
+#if ! defined( ZHANG ) && ( defined( VEB ) || defined( LEAFPAIR ) )
+// Rank the heap-numbered nodes (root 1) of a complete binary tree of the given height in van Emde Boas order: the top
+// half of the levels is laid out recursively, followed by each bottom subtree laid out recursively.
+static void tree_veb( unsigned int root, unsigned int height, unsigned int *order, unsigned int *posn ) {
+	if ( height == 1 ) {
+		order[*posn] = root;
+		*posn += 1;
+		return;
+	} // if
+	unsigned int bottom = height / 2, top = height - bottom;
+	tree_veb( root, top, order, posn );
+	for ( unsigned int i = 0; i < (1u << top); i += 1 ) {
+		tree_veb( (root << top) + i, bottom, order, posn );
+	} // for
+} // tree_veb
+#endif // ! ZHANG && ( VEB || LEAFPAIR )
+
+void __attribute__((noinline)) tree_ctor( unsigned int degree ) {
+#ifndef ZHANG
+	if ( degree != 2 ) {
+		printf( "Usage: 2-thread tree node requires d-ary 2, not %u.\n", degree );
+		exit( EXIT_FAILURE );
+	} // if
+#endif // ! ZHANG
+	const size_t size = sizeof(Node) * (NodeStride == 0 ? degree : NodeStride); // bytes per match
+
+	// Only the last node of a level can be partial, and it is elided when it has a single contender.
+	depth = 0;
+	for ( unsigned int m = N; m > 1; m = (m + degree - 1) / degree ) depth += 1;
+	unsigned int counts[depth + 1], bases[depth + 1], total = 0; // matches per level, first match of level
+	for ( unsigned int m = N, j = 0; m > 1; m = (m + degree - 1) / degree, j += 1 ) {
+		counts[j] = m / degree + (m % degree > 1);
+		bases[j] = total;
+		total += counts[j];
+	} // for
+
+	size_t offsets[total == 0 ? 1 : total], top = 0;	// byte offset of each match
+#if ! defined( ZHANG ) && ( defined( VEB ) || defined( LEAFPAIR ) )
+	// Binary matches (j,k) map onto the heap numbering of the complete tree of the same depth.
+	unsigned int order[1u << depth], posn = 0;
+	if ( depth > 0 ) tree_veb( 1, depth, order, &posn );
+#ifdef LEAFPAIR
+	for ( unsigned int k = 0; k < counts[0]; k += 1 ) {	// leaf matches, one line each
+		offsets[bases[0] + k] = tree_place( &top, CACHE_ALIGN );
+	} // for
+#endif // LEAFPAIR
+	for ( unsigned int i = 0; i < posn; i += 1 ) {
+		unsigned int r = Log2( order[i] ), j = depth - 1 - r, k = order[i] - (1u << r);
+#ifdef LEAFPAIR
+	  if ( j == 0 ) continue;							// already placed
+#endif // LEAFPAIR
+	  if ( k >= counts[j] ) continue;					// match not in tree
+		offsets[bases[j] + k] = tree_place( &top, size );
+	} // for
+#else
+	for ( unsigned int n = 0; n < total; n += 1 ) {		// level order
+		offsets[n] = tree_place( &top, size );
+	} // for
+#endif // ! ZHANG && ( VEB || LEAFPAIR )
+	nodes = Allocator( top == 0 ? CACHE_ALIGN : top );
+#ifdef MIXED
+	unsigned int algs[depth + 1];
+	mixed( depth, algs );
+#endif // MIXED
+	for ( unsigned int n = 0; n < total; n += 1 ) {
+		node_ctor( (Node *)(nodes + offsets[n]), degree );
+	} // for
+
+	paths = Allocator( sizeof(typeof(paths[0])) * N );
+	heights = Allocator( sizeof(typeof(heights[0])) * N );
+	for ( unsigned int id = 0; id < N; id += 1 ) {
+		paths[id] = Allocator( sizeof(typeof(paths[0][0])) * (depth == 0 ? 1 : depth) );
+		unsigned int l = id, h = 0;
+		for ( unsigned int m = N, j = 0; m > 1; m = (m + degree - 1) / degree, j += 1 ) {
+			unsigned int k = l / degree;				// node at this level
+			unsigned int ws = m - k * degree < degree ? m - k * degree : degree;
+			if ( ws > 1 ) {								// match to play ?
+				paths[id][h] = (Path){ .ns = (Node *)(nodes + offsets[bases[j] + k]), .es = l % degree,
+#ifdef ZHANG
+									   .ws = ws,
+#endif // ZHANG
+#ifdef MIXED
+									   .as = algs[j],
+#endif // MIXED
+				};
+				h += 1;
+			} // if
+			l = k;
+		} // for
+		heights[id] = h;
+	} // for
+} // tree_ctor
+
+void __attribute__((noinline)) tree_dtor() {
+	for ( unsigned int id = 0; id < N; id += 1 ) {
+		free( paths[id] );
+	} // for
+	free( heights );
+	free( paths );
+	free( nodes );
+} // tree_dtor
+
+// Local Variables: //
+// tab-width: 4 //
+// End: //
@@ -35,6 +35,10 @@ static TYPE PAD CALIGN __attribute__(( unused ));		// protect further false shar
 
 #define await( E ) while ( ! (E) ) Pause()
 
+// With CNT, fast counts entries through entryFast (Lamport fast path) and aside entries through the tournament tree.
+#define COUNTERS( C ) C( fast ) C( aside )
+DeclareCounters( COUNTERS )
+
 static inline void binary( int id ) {
 	binary_prologue( id, &B );
 	//bintents[id] = true;
@@ -90,32 +94,34 @@ static void *Worker( void *arg ) {
 			goto aside;
 		  cont: ;
 #else
-			if ( FASTPATH( y != N ) ) goto aside;
-			b[id] = true;								// entry protocol
-			x = id;
+			if ( FASTPATH( LD( y ) != N ) ) goto aside;
+			ST( b[id], true );							// entry protocol
+			ST( x, id );
 			Fence();									// force store before more loads
-			if ( FASTPATH( y != N ) ) {
-				b[id] = false;
+			if ( FASTPATH( LD( y ) != N ) ) {
+				ST( b[id], false );
 				goto aside;
 			} // if
-			y = id;
+			ST( y, id );
 			Fence();									// force store before more loads
-			if ( FASTPATH( x != id ) ) {
-				b[id] = false;
+			if ( FASTPATH( LD( x ) != id ) ) {
+				ST( b[id], false );
 				Fence();								// force store before more loads
-				for ( int j = 0; y == id && j < N ; j += 1 )
-					await( ! b[j] );
-				if ( FASTPATH( y != id ) ) goto aside;
+				for ( int j = 0; LD( y ) == id && j < N ; j += 1 )
+					await( ! LD( b[j] ) );
+				if ( FASTPATH( LD( y ) != id ) ) goto aside;
 			} // if
 #endif
 
+			Count( fast );
 			binary( 1 );
 
-			y = N;										// exit protocol
-			b[id] = false;
+			ST( y, N );									// exit protocol
+			ST( b[id], false );
 			goto fini;
 
 		  aside:
+			Count( aside );
 #if defined( __sparc )
 			__asm__ __volatile__ ( "" : : : "memory" );
 #endif // __sparc
@@ -154,6 +160,7 @@ static void *Worker( void *arg ) {
 			cnt = cycleUp( cnt, NoStartPoints );
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -2,11 +2,19 @@
 // Shared-Memory Multiprocessors, Parallel Distributed Technology: Systems Applications, IEEE, 1996, 4(1), Figure 14,
 // p. 37
 
-static volatile TYPE **x CALIGN;
+#define ZHANG											// d-thread node at each match
 
-#define min( x, y ) (x < y ? x : y)
-#define logx( N, b ) (log(N) / log(b))
+#include "Tree.c"
 
+static inline void entryProtocol( TYPE id ) {
+	tree_entry( id );									// leaf to root
+} // entryProtocol
+
+static inline void exitProtocol( TYPE id ) {
+	tree_exit( id );									// retract reverse order
+} // exitProtocol
+
+#ifndef NOWORKER
 static void *Worker( void *arg ) {
 	TYPE id = (size_t)arg;
 	uint64_t entry;
@@ -14,49 +22,18 @@ static void *Worker( void *arg ) {
 	unsigned int cnt = 0, oid = id;
 #endif // FAST
 
-	int high, k, i, j, l, len;
-
 	for ( int r = 0; r < RUNS; r += 1 ) {
 		entry = 0;
-		high = ceil( logx( N, Degree ) );				// maximal depth of binary tree
-		j = 0;
-		l = id;
 		while ( stop == 0 ) {
-			k = id / Degree;
-			len = N;
-			while ( j < high ) {
-			  yy: x[j][l] = 1;
-				Fence();								// force store before more loads
-				for ( i = k * Degree; i < l; i += 1 ) {
-					if ( x[j][i] ) {
-						x[j][l] = 0;
-						Fence();						// force store before more loads
-						while ( x[j][i] != 0 ) Pause();
-						goto yy;
-					} // if
-				} // for
-				for ( i = l + 1; i < min((k + 1) * Degree, len); i += 1 )
-					while ( x[j][i] ) Pause();
-				l = l / Degree;
-				k = k / Degree;
-				j += 1;
-				len = (len % Degree == 0) ? len / Degree : len / Degree + 1;
-			} // for
+			entryProtocol( id );
 			CriticalSection( id );
-			//j = high;
-			int pow2 = pow( Degree, high );
-			while ( j > 0 ) {
-				j -= 1;
-				pow2 /= Degree;
-				l = id / pow2;
-				x[j][l] = 0;
-			} // while
+			exitProtocol( id );
 #ifdef FAST
 			id = startpoint( cnt );						// different starting point each experiment
 			cnt = cycleUp( cnt, NoStartPoints );
-			l = id;
 #endif // FAST
 			entry += 1;
+			Passage( id );
 		} // while
 #ifdef FAST
 		id = oid;
@@ -68,6 +45,7 @@ static void *Worker( void *arg ) {
 	} // for
 	return NULL;
 } // Worker
+#endif // ! NOWORKER
 
 void ctor() {
 	if ( Degree == -1 ) {
@@ -75,22 +53,11 @@ void ctor() {
 		exit( EXIT_FAILURE );
 	} // if
 
-	x = Allocator( sizeof(typeof(x[0])) * N );
-	for ( int i = 0; i < N; i += 1 ) {
-		x[i] = Allocator( sizeof(typeof(x[0][0])) * N );
-	} // for
-	for ( int i = 0; i < N; i += 1 ) {					// initialize shared data
-		for ( int j = 0; j < N; j += 1 ) {
-			x[i][j] = 0;
-		} // for
-	} // for
+	tree_ctor( Degree );								// d-ary tree of d-thread nodes
 } // ctor
 
 void dtor() {
-	for ( int i = 0; i < N; i += 1 ) {
-		free( (void *)x[i] );
-	} // for
-	free( (void *)x );
+	tree_dtor();
 } // dtor
 
 // Local Variables: //
@@ -0,0 +1,448 @@
+// Microbenchmark of the lib/Locks.h classes repeating the Harness.c experiment: N threads repeatedly enter the same
+// self-checking critical section for Time seconds, RUNS times, and the median run is printed in the harness format
+// "N Time median avg std rstd%".  Running a library class and the corresponding harness algorithm with the same
+// arguments checks the library reaches the harness throughput, e.g.:
+//
+//   g++ -std=c++17 -Wall -O3 -DNDEBUG -DPIN lib/Bench.cc -lpthread -o bench ; ./bench MCS 8 10
+//   gcc -Wall -std=gnu11 -O3 -DNDEBUG -fno-reorder-functions -DPIN -DAlgorithm=MCS Harness.c -lpthread -lm ; ./a.out 8 10
+//
+// Algorithms: SpinLock MCS CLH LamportBakery LamportFast LamportRetract BurnsLynch TaubenfeldBuhr ZhangdT (d-ary
+// 2/4/8/16) Triangle ElevatorQueue (harness ElevatorQueue -DCAS -DFLAG).  The lock capacity is -DCAP=C (default 64) and the lock scans N <= C threads.
+//
+// "bench footprint" prints, for each algorithm and N, the bytes of shared words an instance needs and its inline
+// size (including padding) with capacity N.
+//
+// With -DSTRIPE=K, a passage locks one of K lock instances, each striping its own owner word and counter (like a
+// lock-striped hash table), chosen with Zipf skew -DSKEW=s (default 0, uniform), so footprint, cache pressure and
+// striping efficiency are measured together.  The result line is followed by the stripe size in bytes, and the
+// counters are checked against the entries.
+//
+// With -DCHURN=k, each of the N lanes repeatedly starts a thread that registers (takes a slot), makes k passages and
+// exits (releasing its slot), so the threads come and go like a thread pool.  The result line is followed by the
+// number of threads started and the average registration time.  A new thread reuses the lowest free slot, i.e., the
+// tree leaf of an exited thread.
+//
+// With -DABORT=p, p percent of the attempts are timed, try_lock_for( -DPATIENCE=us microseconds, default 1 ), and a
+// timed-out attempt is abandoned (not an entry) before the thread tries again, so the throughput impact of aborting is
+// measured against ABORT=0.  The result line is followed by the number of aborts and the average abort latency, i.e.,
+// the time from the deadline until try_lock_for returns with the attempt withdrawn.  Only TimedLockable algorithms run.
+//
+// With -DSTATS, each lock is wrapped in Stat (lockstat-style sampled statistics), so comparing the throughput with and
+// without STATS gives the statistics overhead.  The result line is followed by the snapshot over all runs (and stripes):
+// acquisitions, sampled contention ("n/a" for a lock without try_lock, whose contention is unknown), average and maximum
+// wait and the longest waiter's slot, and average hold, in ticks.
+
+#include "Locks.h"
+#include <algorithm>									// sort
+#include <chrono>
+#include <cerrno>										// errno
+#include <cmath>										// sqrt
+#include <cstring>										// strcmp
+#include <memory>										// unique_ptr
+#include <new>											// align_val_t
+#include <vector>
+#include <thread>
+#include <type_traits>								// void_t
+#include <unistd.h>										// sleep
+#include <pthread.h>
+
+using namespace locks;
+
+#ifndef CAP
+#define CAP 64
+#endif // ! CAP
+
+enum { RUNS = 5, CSLength = 100, MaxThreads = CAP };
+#define median(a) ((RUNS & 1) == 0 ? (a[RUNS/2-1] + a[RUNS/2]) / 2 : a[RUNS/2] )
+
+static unsigned int N = 8, Time = 10;					// defaults
+static std::atomic<TYPE> stop{ 0 }, Arrived{ 0 };
+static uint64_t entries[RUNS][MaxThreads];
+
+static inline void CriticalSection( const TYPE id, Word &CurrTid ) { // CurrTid is current thread id in critical section
+	CurrTid = id;
+	Fence();
+	for ( int i = 1; i <= CSLength; i += 1 ) {			// delay
+		if ( CurrTid != id ) {							// mutual exclusion violation ?
+			printf( "Interference Id:%zu\n", (size_t)id );
+			abort();
+		} // if
+	} // for
+} // CriticalSection
+
+static void affinity( pthread_t pthreadid __attribute__(( unused )), unsigned int tid __attribute__(( unused )) ) {
+#if defined( __linux ) && defined( PIN )
+	enum { OFFSET = 32 };								// upper range of cores away from core 0, as Harness.c
+	cpu_set_t mask;
+	CPU_ZERO( &mask );
+	CPU_SET( tid + OFFSET, &mask );
+	int rc = pthread_setaffinity_np( pthreadid, sizeof(cpu_set_t), &mask );
+	if ( rc != 0 ) {
+		errno = rc;
+		perror( "setaffinity" );
+		abort();
+	} // if
+#endif // linux && PIN
+} // affinity
+
+#ifdef ABORT
+
+#ifndef PATIENCE
+#define PATIENCE 1
+#endif // ! PATIENCE
+
+template<typename Lock, typename = void> struct TimedLockable : std::false_type {};
+template<typename Lock> struct TimedLockable<Lock, std::void_t<decltype( std::declval<Lock &>().try_lock_for( std::chrono::microseconds( 1 ) ) )>> : std::true_type {};
+
+static thread_local uint64_t aborted;					// thread's aborted attempts
+static thread_local double late;						// thread's nanoseconds from deadline to abort return
+static uint64_t aborts[RUNS][MaxThreads];
+static double lates[RUNS][MaxThreads];
+
+#endif // ABORT
+
+template<typename Lock> static inline void acquire( Lock &lock, uint64_t &seed __attribute__(( unused )) ) {
+#ifdef ABORT
+	if constexpr ( TimedLockable<Lock>::value ) {
+		for ( ;; ) {
+			seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; // xorshift64
+		  if ( seed % 100 >= ABORT ) break;				// untimed attempt
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds( PATIENCE );
+		  if ( lock.try_lock_until( deadline ) ) return;
+			aborted += 1;
+			late += std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - deadline ).count();
+		} // for
+	} // if
+#endif // ABORT
+	lock.lock();
+} // acquire
+
+#ifdef STRIPE
+
+#ifndef SKEW
+#define SKEW 0
+#endif // ! SKEW
+
+template<typename Lock> struct Stripe {
+	Lock lock;
+	Word owner;											// thread id in critical section
+	TYPE count = 0;										// protected data
+	template<typename... Args> Stripe( Args... args ) : lock( args... ) {}
+}; // Stripe
+
+template<typename Lock> class Stripes {
+	Stripe<Lock> *stripes;
+	std::vector<double> cdf;							// Zipf cumulative distribution, empty => uniform
+  public:
+	template<typename... Args> Stripes( Args... args ) {
+		stripes = static_cast<Stripe<Lock> *>( ::operator new[]( sizeof(Stripe<Lock>) * STRIPE, std::align_val_t( alignof(Stripe<Lock>) ) ) );
+		for ( unsigned int k = 0; k < STRIPE; k += 1 ) new( &stripes[k] ) Stripe<Lock>( args... );
+		if ( SKEW != 0 ) {
+			double sum = 0.0;
+			cdf.resize( STRIPE );
+			for ( unsigned int k = 0; k < STRIPE; k += 1 ) cdf[k] = sum += 1.0 / pow( k + 1, SKEW );
+			for ( unsigned int k = 0; k < STRIPE; k += 1 ) cdf[k] /= sum;
+		} // if
+	} // Stripes
+
+	~Stripes() {
+		for ( unsigned int k = 0; k < STRIPE; k += 1 ) stripes[k].~Stripe<Lock>();
+		::operator delete[]( stripes, std::align_val_t( alignof(Stripe<Lock>) ) );
+	} // ~Stripes
+
+	Stripe<Lock> &pick( uint64_t &seed ) {				// xorshift64
+		seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+	  if ( cdf.empty() ) return stripes[seed % STRIPE];
+		double u = (seed >> 11) * 0x1.0p-53;			// [0,1)
+		size_t k = std::upper_bound( cdf.begin(), cdf.end(), u ) - cdf.begin();
+		return stripes[k < STRIPE ? k : STRIPE - 1];
+	} // pick
+
+	const Stripe<Lock> &stripe( unsigned int k ) const { return stripes[k]; }
+
+	uint64_t total() const {
+		uint64_t sum = 0;
+		for ( unsigned int k = 0; k < STRIPE; k += 1 ) sum += stripes[k].count;
+		return sum;
+	} // total
+}; // Stripes
+
+template<typename Lock> static inline void passage( Stripes<Lock> &stripes, TYPE id, uint64_t &seed ) {
+	Stripe<Lock> &s = stripes.pick( seed );
+	acquire( s.lock, seed );
+	CriticalSection( id, s.owner );
+	s.count += 1;
+	s.lock.unlock();
+} // passage
+
+#endif // STRIPE
+
+template<typename Lock> static inline void passage( Lock &lock, TYPE id, uint64_t &seed ) {
+	alignas(CACHE_ALIGN) static Word CurrTid;			// shared, current thread id in critical section
+	acquire( lock, seed );
+	CriticalSection( id, CurrTid );
+	lock.unlock();
+} // passage
+
+#ifdef CHURN
+static uint64_t starts[RUNS][MaxThreads];				// threads started by each lane
+static double registers[RUNS][MaxThreads];				// nanoseconds registering the lane's threads
+#endif // CHURN
+
+template<typename Shared> static void Worker( Shared &shared, unsigned int lane ) {
+	uint64_t entry;
+#ifndef CHURN
+	const TYPE id = slot();								// first slot use, threads are numbered 0..N-1
+	uint64_t seed = id * 0x9E3779B97F4A7C15ull + 1;
+#endif // ! CHURN
+
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		entry = 0;
+#ifdef ABORT
+		aborted = late = 0;
+		aborts[r][lane] = 0;
+		lates[r][lane] = 0.0;
+#endif // ABORT
+#ifdef CHURN
+		starts[r][lane] = 0;
+		registers[r][lane] = 0.0;
+		while ( stop == 0 ) {							// lane replaces its thread after CHURN passages
+			std::thread t( [&shared, &entry, r, lane]{
+				auto start = std::chrono::steady_clock::now();
+				const TYPE id = slot();					// register
+				registers[r][lane] += std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+				uint64_t seed = (id + entry) * 0x9E3779B97F4A7C15ull + 1;
+				for ( unsigned int k = 0; k < CHURN && stop == 0; k += 1 ) {
+					passage( shared, id, seed );
+					entry += 1;
+				} // for
+#ifdef ABORT
+				aborts[r][lane] += aborted;
+				lates[r][lane] += late;
+#endif // ABORT
+			} ); // slot released at thread exit
+			t.join();
+			starts[r][lane] += 1;
+		} // while
+#else
+		while ( stop == 0 ) {
+			passage( shared, id, seed );
+			entry += 1;
+		} // while
+#ifdef ABORT
+		aborts[r][lane] = aborted;
+		lates[r][lane] = late;
+#endif // ABORT
+#endif // CHURN
+		entries[r][lane] = entry;
+		Arrived += 1;
+		while ( stop != 0 ) Pause();
+		Arrived -= 1;
+	} // for
+} // Worker
+
+template<typename Shared> static void run( Shared &shared ) {
+	std::vector<std::thread> workers( N );
+	for ( unsigned int tid = 0; tid < N; tid += 1 ) {	// start workers
+		workers[tid] = std::thread( [&shared, tid]{ Worker( shared, tid ); } );
+		affinity( workers[tid].native_handle(), tid );
+	} // for
+
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		sleep( Time );
+		stop = 1;										// reset
+		while ( Arrived != N ) Pause();
+		stop = 0;
+		while ( Arrived != 0 ) Pause();
+	} // for
+
+	for ( unsigned int tid = 0; tid < N; tid += 1 ) {	// terminate workers
+		workers[tid].join();
+	} // for
+} // run
+
+#ifdef STRIPE
+static size_t stripeBytes = 0;
+#endif // STRIPE
+
+#ifdef STATS
+static LockStat stats;
+#endif // STATS
+
+template<typename Algorithm, typename... Args> static void run( Args... args ) {
+#ifdef STATS
+	typedef Stat<Algorithm, MaxThreads> Lock;
+#else
+	typedef Algorithm Lock;
+#endif // STATS
+#ifdef ABORT
+	if constexpr ( ! TimedLockable<Lock>::value ) {
+		printf( "\nAlgorithm is not abortable\n" );
+		exit( EXIT_FAILURE );
+	} // if
+#endif // ABORT
+#ifdef STRIPE
+	Stripes<Lock> stripes( args... );
+	run( stripes );
+	uint64_t sum = 0;
+	for ( int r = 0; r < RUNS; r += 1 )
+		for ( unsigned int tid = 0; tid < N; tid += 1 ) sum += entries[r][tid];
+	if ( stripes.total() != sum ) {						// lost update ?
+		printf( "Interference counters:%ju entries:%ju\n", stripes.total(), sum );
+		abort();
+	} // if
+	stripeBytes = sizeof(Stripe<Lock>);
+#ifdef STATS
+	for ( unsigned int k = 0; k < STRIPE; k += 1 ) stats += stripes.stripe( k ).lock.snapshot();
+#endif // STATS
+#else
+	std::unique_ptr<Lock> lock( new Lock( args... ) );	// aligned new, locks can be large
+	run( *lock );
+#ifdef STATS
+	stats = lock->snapshot();
+#endif // STATS
+#endif // STRIPE
+} // run
+
+template<unsigned int Cap> using ZhangdT4 = ZhangdT<Cap, 4>;
+
+template<unsigned int... Caps> struct Footprint {		// shared-word bytes/inline bytes for each capacity
+	template<typename Lock> static void print( const char *name ) {
+		printf( "%-16s", name );
+		((printf( " %7zu/%-7zu", Lock::words( Caps ) * sizeof(TYPE), sizeof(Lock) )), ...);
+		printf( "\n" );
+	} // print
+
+	template<template<unsigned int> class Lock> static void print( const char *name ) {
+		printf( "%-16s", name );
+		((printf( " %7zu/%-7zu", Lock<Caps>::words( Caps ) * sizeof(TYPE), sizeof(Lock<Caps>) )), ...);
+		printf( "\n" );
+	} // print
+
+	static void print() {
+		printf( "%-16s", "N" );
+		((printf( " %15u", Caps )), ...);
+		printf( "\n" );
+		print<SpinLock>( "SpinLock" );
+		print<MCS>( "MCS" );
+		print<CLH>( "CLH" );
+		print<LamportBakery>( "LamportBakery" );
+		print<LamportFast>( "LamportFast" );
+		print<LamportRetract>( "LamportRetract" );
+		print<BurnsLynch>( "BurnsLynch" );
+		print<TaubenfeldBuhr>( "TaubenfeldBuhr" );
+		print<ZhangdT4>( "ZhangdT(4)" );
+		print<Triangle>( "Triangle" );
+		print<ElevatorQueue>( "ElevatorQueue" );
+	} // print
+}; // Footprint
+
+int main( int argc, char *argv[] ) {
+	unsigned int Degree = 2;
+
+	switch ( argc ) {
+	  case 5:
+		Degree = atoi( argv[4] );
+		if ( Degree != 2 && Degree != 4 && Degree != 8 && Degree != 16 ) goto usage;
+		[[fallthrough]];
+	  case 4:
+		Time = atoi( argv[3] );
+		N = atoi( argv[2] );
+		if ( (int)Time < 1 || (int)N < 1 || N > MaxThreads ) goto usage;
+		break;
+	  case 2:											// defaults
+		break;
+	  usage:
+	  default:
+		printf( "Usage: %s algorithm [ %d (number of threads <= %d) %d (time in seconds threads spend entering critical section) [ %d (Zhang D-ary 2/4/8/16) ] ]\n",
+				argv[0], N, MaxThreads, Time, Degree );
+		exit( EXIT_FAILURE );
+	} // switch
+
+	const char *name = argv[1];
+	if ( strcmp( name, "footprint" ) == 0 ) {
+		Footprint<2, 4, 8, 16, 32, 64>::print();
+		return 0;
+	} // if
+	printf( "%d %d ", N, Time );
+	fflush( stdout );
+
+	if ( strcmp( name, "SpinLock" ) == 0 ) run<SpinLock>();
+	else if ( strcmp( name, "MCS" ) == 0 ) run<MCS>();
+	else if ( strcmp( name, "CLH" ) == 0 ) run<CLH>();
+	else if ( strcmp( name, "LamportBakery" ) == 0 ) run<LamportBakery<MaxThreads>>( N );
+	else if ( strcmp( name, "LamportFast" ) == 0 ) run<LamportFast<MaxThreads>>( N );
+	else if ( strcmp( name, "LamportRetract" ) == 0 ) run<LamportRetract<MaxThreads>>( N );
+	else if ( strcmp( name, "BurnsLynch" ) == 0 ) run<BurnsLynch<MaxThreads>>( N );
+	else if ( strcmp( name, "TaubenfeldBuhr" ) == 0 ) run<TaubenfeldBuhr<MaxThreads>>( N );
+	else if ( strcmp( name, "ZhangdT" ) == 0 ) {
+		switch ( Degree ) {
+		  case 2: run<ZhangdT<MaxThreads, 2>>( N ); break;
+		  case 4: run<ZhangdT<MaxThreads, 4>>( N ); break;
+		  case 8: run<ZhangdT<MaxThreads, 8>>( N ); break;
+		  case 16: run<ZhangdT<MaxThreads, 16>>( N ); break;
+		} // switch
+	} else if ( strcmp( name, "Triangle" ) == 0 ) run<Triangle<MaxThreads>>( N );
+	else if ( strcmp( name, "ElevatorQueue" ) == 0 ) run<ElevatorQueue<MaxThreads>>( N );
+	else {
+		printf( "\nUnknown algorithm %s\n", name );
+		exit( EXIT_FAILURE );
+	} // if
+
+	uint64_t totals[RUNS], sort[RUNS];
+	for ( int r = 0; r < RUNS; r += 1 ) {
+		totals[r] = 0;
+		for ( unsigned int tid = 0; tid < N; tid += 1 ) {
+			totals[r] += entries[r][tid];
+		} // for
+		sort[r] = totals[r];
+	} // for
+	std::sort( sort, sort + RUNS );
+	uint64_t med = median( sort );
+	printf( "%ju", med );								// median round
+
+	unsigned int posn;									// run with median result
+	for ( posn = 0; posn < RUNS && totals[posn] != med; posn += 1 ); // assumes RUNS is odd
+	double avg = (double)totals[posn] / N;				// average
+	double sum = 0.0;
+	for ( unsigned int tid = 0; tid < N; tid += 1 ) {	// sum squared differences from average
+		double diff = entries[posn][tid] - avg;
+		sum += diff * diff;
+	} // for
+	double stdev = sqrt( sum / N );
+	printf( " %.1f %.1f %.1f%%", avg, stdev, avg == 0 ? 0.0 : stdev / avg * 100 );
+#ifdef CHURN
+	uint64_t started = 0;
+	double registered = 0.0;
+	for ( unsigned int tid = 0; tid < N; tid += 1 ) {
+		started += starts[posn][tid];
+		registered += registers[posn][tid];
+	} // for
+	printf( " churn:%u starts:%ju register:%.0fns", CHURN, started, started == 0 ? 0.0 : registered / started );
+#endif // CHURN
+#ifdef ABORT
+	uint64_t aborts = 0;
+	double late = 0.0;
+	for ( unsigned int tid = 0; tid < N; tid += 1 ) {
+		aborts += ::aborts[posn][tid];
+		late += lates[posn][tid];
+	} // for
+	printf( " abort:%u%% patience:%uus aborts:%ju latency:%.0fns", ABORT, PATIENCE, aborts, aborts == 0 ? 0.0 : late / aborts );
+#endif // ABORT
+#ifdef STRIPE
+	printf( " stripes:%u skew:%g bytes/stripe:%zu", STRIPE, (double)SKEW, stripeBytes );
+#endif // STRIPE
+#ifdef STATS
+	char contended[16] = "n/a";
+	if ( stats.contentionKnown ) snprintf( contended, sizeof(contended), "%.1f%%", stats.contention() * 100 );
+	printf( " stats sample:%u acquisitions:%ju contended:%s wait:%.0f maxwait:%ju waiter:%d hold:%.0f",
+			LOCKS_SAMPLE, stats.acquisitions, contended, stats.avgwait(), stats.maxwait, (int)stats.waiter, stats.avghold() );
+#endif // STATS
+	printf( "\n" );
+} // main
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-mode: "c++-mode" //
+// compile-command: "g++ -Wall -std=c++17 -O3 -DNDEBUG -DPIN Bench.cc -lpthread" //
+// End: //
@@ -0,0 +1,1051 @@
+// Header-only C++17 packaging of the harness algorithms as lock objects usable with std::lock_guard,
+// std::unique_lock and std::scoped_lock, e.g.:
+//
+//   #include "lib/Locks.h"
+//   static locks::TaubenfeldBuhr<64> tb;				// at most 64 threads
+//   { std::lock_guard<locks::TaubenfeldBuhr<64>> g( tb ); ... }
+//
+// The harness passes each worker a dense id in [0,N); here a thread's id (slot) is taken from a process-wide
+// allocator on its first lock operation and returned when the thread exits, so ids stay dense as threads come and go.
+// Algorithms whose storage depends on N take the capacity Cap as a template parameter, so all storage is inline and
+// sized at compile time; the constructor argument n <= Cap is the number of threads actually scanned, as N is in the
+// harness.  A thread whose slot is >= n aborts.
+//
+// Shared words are std::atomic with acquire loads and release stores, which are plain loads and stores on x86 and
+// SPARC TSO, and Fence() is the harness ST-LD barrier, so the generated code matches the harness.
+//
+// All classes are BasicLockable (lock/unlock).  Classes that can abandon an attempt also provide try_lock (Lockable),
+// and those that can abandon it at any point of their wait also provide try_lock_for and try_lock_until
+// (TimedLockable), through Timed and lock_until( Deadline & ):
+//   Lockable        MCS (only while the queue is empty)
+//   TimedLockable   SpinLock, CLH (queue, abandoned node), LamportBakery (withdraw ticket), LamportRetract,
+//                   BurnsLynch (retract intent), TaubenfeldBuhr and ZhangdT (unwind path)
+//
+// Stat<L, Cap> wraps any of them with sampled lockstat-style contention statistics read by snapshot().
+//
+// Each class is an independent instance, so a program can have any number of them, e.g., one per hash-table stripe.
+// words( n ) is the number of shared words an instance needs for n threads, excluding cache-line padding, whereas
+// sizeof is the inline footprint for capacity Cap, including padding.
+
+#ifndef LOCKS_H
+#define LOCKS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>										// uintptr_t
+#include <cstdio>										// fprintf
+#include <cstdlib>										// abort
+#include <type_traits>									// void_t
+
+namespace locks {
+
+#if defined( __sparc )
+enum { CACHE_ALIGN = 4 };
+#else
+enum { CACHE_ALIGN = 64 };
+#endif // SPARC
+
+typedef uintptr_t TYPE;									// atomically addressable word-size
+
+// pause to prevent excess processor bus usage
+static inline void Pause() {
+#if defined( __sparc )
+	__asm__ __volatile__ ( "rd %ccr,%g0" );
+#elif defined( __i386 ) || defined( __x86_64 )
+	__asm__ __volatile__ ( "pause" : : : );
+#endif
+} // Pause
+
+// Architectural ST-LD barrier, see Harness.c for why not std::atomic_thread_fence().  The memory clobber also stops
+// the compiler moving atomic accesses across the barrier.
+static inline void Fence() {
+#if defined( __sparc )
+	__asm__ __volatile__ ( "membar #StoreLoad;" ::: "memory" );
+#elif defined( __x86_64 )
+	__asm__ __volatile__ ( "lock; addq $0,(%%rsp);" ::: "cc", "memory" );
+#elif defined( __i386 )
+	__asm__ __volatile__ ( "lock; addl $0,(%%esp);" ::: "cc", "memory" );
+#else
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+#endif
+} // Fence
+
+#define LOCKS_AWAIT( E ) while ( ! (E) ) Pause()
+
+static inline unsigned int Log2( unsigned int n ) {		// integer floor( log2( n ) ), n >= 1
+	return sizeof(n) * __CHAR_BIT__ - 1 - __builtin_clz( n );
+} // Log2
+
+static constexpr unsigned int Clog2( unsigned int n ) {	// integer ceil( log2( n ) ), n >= 1
+	return n <= 1 ? 0 : 1 + Clog2( (n + 1) / 2 );
+} // Clog2
+
+static constexpr unsigned int MaxMatches( unsigned int n ) { // n threads need at most n - 1 matches, at least 1 slot
+	return n > 1 ? n - 1 : 1;
+} // MaxMatches
+
+// Shared word read and written like a volatile in the harness: loads acquire, stores release.
+class Word {
+	std::atomic<TYPE> v;
+  public:
+	Word( TYPE i = 0 ) : v( i ) {}
+	operator TYPE() const { return v.load( std::memory_order_acquire ); }
+	Word &operator=( TYPE i ) { v.store( i, std::memory_order_release ); return *this; }
+	bool cas( TYPE cmp, TYPE set ) { return v.compare_exchange_strong( cmp, set, std::memory_order_acq_rel ); }
+}; // Word
+
+// Deadline polled in a spin loop, reading the clock every Poll polls.  The default deadline has already passed, so a
+// wait is abandoned at its first poll (try_lock).
+class Deadline {
+	enum { Poll = 64 };
+	std::chrono::steady_clock::time_point t;
+	unsigned int polls = 0;
+	const bool now;										// zero patience
+  public:
+	Deadline() : now( true ) {}
+	template<class Clock, class Duration> explicit Deadline( const std::chrono::time_point<Clock, Duration> &abs ) :
+		t( std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>( abs - Clock::now() ) ), now( false ) {}
+
+	bool expired() {
+		return now || ( (polls += 1) % Poll == 0 && std::chrono::steady_clock::now() >= t );
+	} // expired
+}; // Deadline
+
+// TimedLockable operations of lock L from L::lock_until( Deadline & ), which returns false after abandoning its
+// attempt, leaving the lock as if the attempt never started.
+template<typename L> struct Timed {
+	bool try_lock() {
+		Deadline d;
+		return static_cast<L *>( this )->lock_until( d );
+	} // try_lock
+
+	template<class Rep, class Period> bool try_lock_for( const std::chrono::duration<Rep, Period> &rel ) {
+		return try_lock_until( std::chrono::steady_clock::now() + rel );
+	} // try_lock_for
+
+	template<class Clock, class Duration> bool try_lock_until( const std::chrono::time_point<Clock, Duration> &abs ) {
+		Deadline d( abs );
+		return static_cast<L *>( this )->lock_until( d );
+	} // try_lock_until
+}; // Timed
+
+//------------------------------------------------------------------------------
+
+// Process-wide thread slots (renaming): a thread acquires the lowest free slot by test-and-set over a bitmap of
+// LOCKS_SLOTS slots.  After losing a bit to another thread, the scan tries only higher free bits of that word and then
+// moves to the next word, so each slot is tried at most once: acquisition is wait-free (at most LOCKS_SLOTS
+// fetch-and-ors) and release is a single fetch-and-and.  A scan fails only if every slot was held when examined, so
+// under heavy churn LOCKS_SLOTS needs headroom above the number of live threads.  A thread caches its slot in a trivial
+// thread_local, so slot() is a load after the first call, and the slot is released on thread exit or by release().
+// Lowest-first reuse keeps slots dense, so a thread replacing an exited one takes its leaf in a tree.
+
+#ifndef LOCKS_SLOTS
+#define LOCKS_SLOTS 1024								// maximum simultaneous threads
+#endif // ! LOCKS_SLOTS
+
+class Slots {
+	enum { Words = (LOCKS_SLOTS + 63) / 64 };
+	static inline std::atomic<uint64_t> used[Words];	// bit per slot
+  public:
+	static unsigned int acquire() {
+		for ( unsigned int w = 0; w < Words; w += 1 ) {
+			uint64_t above = ~0ull;						// bits not yet tried in word
+			for ( uint64_t v = used[w].load( std::memory_order_relaxed ); (~v & above) != 0; ) {
+				uint64_t free = ~v & above, bit = free & -free; // lowest untried free slot in word
+				v = used[w].fetch_or( bit, std::memory_order_acquire );
+			  if ( (v & bit) == 0 ) return w * 64 + __builtin_ctzll( bit ); // won ?
+				above = ~( ( bit << 1 ) - 1 );			// lost, only higher bits, bit 63 => none
+			} // for
+		} // for
+		fprintf( stderr, "locks: more than %d threads hold slots, increase LOCKS_SLOTS\n", LOCKS_SLOTS );
+		abort();
+	} // acquire
+
+	static void release( unsigned int s ) {
+		used[s / 64].fetch_and( ~((uint64_t)1 << (s % 64)), std::memory_order_release );
+	} // release
+}; // Slots
+
+struct SlotHolder {										// releases slot on thread exit
+	unsigned int slot = ~0u;
+	~SlotHolder() { if ( slot != ~0u ) Slots::release( slot ); }
+}; // SlotHolder
+
+inline unsigned int &slotCache() {						// trivial, so no guard check on each access
+	static thread_local unsigned int cache = ~0u;
+	return cache;
+} // slotCache
+
+inline SlotHolder &slotHolder() {
+	thread_local SlotHolder holder;
+	return holder;
+} // slotHolder
+
+inline unsigned int slot() {							// calling thread's slot, inline so one per thread
+	unsigned int &cache = slotCache();
+  if ( cache != ~0u ) return cache;
+	return cache = slotHolder().slot = Slots::acquire();
+} // slot
+
+inline void release() {									// return slot before thread exit, holding no locks
+	unsigned int &cache = slotCache();
+  if ( cache == ~0u ) return;
+	Slots::release( cache );
+	cache = slotHolder().slot = ~0u;
+} // release
+
+inline TYPE slot( unsigned int n ) {					// calling thread's slot, checked against lock capacity
+	unsigned int s = slot();
+	if ( s >= n ) {
+		fprintf( stderr, "locks: thread slot %u exceeds lock capacity %u\n", s, n );
+		abort();
+	} // if
+	return s;
+} // slot
+
+//------------------------------------------------------------------------------
+
+// Test-and-test-and-set with exponential backoff (SpinLock.c).
+
+class SpinLock : public Timed<SpinLock> {
+	alignas(128) std::atomic<TYPE> flag{ 0 };			// Intel recommendation, size padded to alignment
+  public:
+	static constexpr size_t words( unsigned int ) { return 1; } // shared words per instance
+
+	void lock() {
+		enum { SPIN_START = 4, SPIN_END = 64 * 1024, };
+		unsigned int spin = SPIN_START;
+
+		for ( unsigned int i = 1;; i += 1 ) {
+		  if ( try_lock() ) break;
+			for ( volatile unsigned int s = 0; s < spin; s += 1 ) Pause(); // exponential spin
+			if ( i % 64 == 0 ) spin += spin;			// slowly increase by powers of 2
+			if ( spin > SPIN_END ) spin = SPIN_START;	// prevent overflow
+		} // for
+	} // lock
+
+	bool try_lock() {
+		return flag.load( std::memory_order_relaxed ) == 0 && flag.exchange( 1, std::memory_order_acquire ) == 0;
+	} // try_lock
+
+	bool lock_until( Deadline &d ) {
+		while ( ! try_lock() ) {
+		  if ( d.expired() ) return false;
+			Pause();
+		} // while
+		return true;
+	} // lock_until
+
+	void unlock() {
+		flag.store( 0, std::memory_order_release );
+	} // unlock
+}; // SpinLock
+
+//------------------------------------------------------------------------------
+
+// John M. Mellor-Crummey and Michael L. Scott, Algorithms for Scalable Synchronization on Shared-Memory
+// Multiprocessors, ACM Transactions on Computer Systems, 9(1), 1991, Fig. 5, p. 30 (MCS.c).  Queue nodes belong to
+// the thread, not the lock, so an instance is two words whatever the number of threads: a thread takes a free node
+// from its own MaxHeld nodes on entry and the holder records it in the lock, since unlock need not be LIFO.
+
+class MCS {
+	struct alignas(CACHE_ALIGN) Node {
+		std::atomic<Node *> next{ nullptr };
+		Word spin;
+	}; // Node
+
+	enum { MaxHeld = 64 };								// MCS locks a thread can hold at once
+
+	struct Nodes {										// thread's queue nodes
+		Node nodes[MaxHeld];
+		uint64_t used = 0;								// bit per node
+	}; // Nodes
+
+	static Nodes &mine() {
+		thread_local Nodes nodes;
+		return nodes;
+	} // mine
+
+	static Node *get() {
+		Nodes &n = mine();
+		if ( n.used == ~(uint64_t)0 ) {
+			fprintf( stderr, "locks: thread holds more than %d MCS locks\n", MaxHeld );
+			abort();
+		} // if
+		unsigned int i = __builtin_ctzll( ~n.used );	// lowest free node
+		n.used |= (uint64_t)1 << i;
+		Node *node = &n.nodes[i];
+		node->next.store( nullptr, std::memory_order_relaxed );
+		return node;
+	} // get
+
+	static void put( Node *node ) {
+		Nodes &n = mine();
+		n.used &= ~((uint64_t)1 << (node - n.nodes));
+	} // put
+
+	alignas(CACHE_ALIGN) std::atomic<Node *> tail{ nullptr };
+	Node *holder;										// holder's node, only accessed in critical section
+  public:
+	static constexpr size_t words( unsigned int ) { return 2; } // shared words per instance
+
+	void lock() {
+		Node *node = get();
+		Node *pred = tail.exchange( node, std::memory_order_acq_rel ); // fetch-and-store
+		if ( pred != nullptr ) {						// someone on list ?
+			node->spin = 1;								// mark as waiting
+			pred->next.store( node, std::memory_order_release ); // add to list of waiting threads
+			LOCKS_AWAIT( node->spin == 0 );				// busy wait on my spin variable
+		} // if
+		holder = node;
+	} // lock
+
+	bool try_lock() {
+		Node *node = get(), *empty = nullptr;
+		if ( ! tail.compare_exchange_strong( empty, node, std::memory_order_acq_rel ) ) {
+			put( node );
+			return false;
+		} // if
+		holder = node;
+		return true;
+	} // try_lock
+
+	void unlock() {
+		Node *node = holder;
+		if ( node->next.load( std::memory_order_acquire ) == nullptr ) { // no one waiting ?
+			Node *self = node;
+		  if ( tail.compare_exchange_strong( self, nullptr, std::memory_order_acq_rel ) ) { put( node ); return; } // not changed ?
+			LOCKS_AWAIT( node->next.load( std::memory_order_acquire ) != nullptr ); // busy wait for successor
+		} // if
+		node->next.load( std::memory_order_acquire )->spin = 0; // stop their busy wait
+		put( node );									// successor no longer touches node
+	} // unlock
+}; // MCS
+
+//------------------------------------------------------------------------------
+
+// Travis S. Craig, Building FIFO and Priority-Queuing Spin Locks from Atomic Swap, 1993, and Magnusson, Landin and
+// Hagersten, Queue Locks on Cache Coherent Multiprocessors, 1994, with the timeout of Michael L. Scott and William N.
+// Scherer III, Scalable Queue-Based Spin Locks with Timeout, PPoPP, 2001 (as in Herlihy and Shavit's TOLock).  A
+// waiter spins on its predecessor's node, whose pred field is Waiting, Available (released) or, for an abandoned node,
+// the abandoning thread's predecessor, which the successor then spins on instead.  A timed-out thread without a
+// successor swings the tail back to its predecessor.  A node is reclaimed by the thread that moves past it, or by its
+// owner when nobody follows, into the reclaiming thread's free list.
+
+class CLH : public Timed<CLH> {
+	struct alignas(CACHE_ALIGN) Node {
+		std::atomic<Node *> pred;
+		Node *free;										// free-list link
+	}; // Node
+
+	static inline Node available;						// sentinel, predecessor released lock
+	static constexpr Node *Waiting = nullptr;
+
+	struct Pool {										// thread's free nodes
+		Node *head = nullptr;
+		~Pool() { while ( head != nullptr ) { Node *n = head; head = n->free; delete n; } }
+	}; // Pool
+
+	static Pool &pool() {
+		thread_local Pool p;
+		return p;
+	} // pool
+
+	static Node *get() {
+		Pool &p = pool();
+		Node *node = p.head;
+		if ( node != nullptr ) p.head = node->free; else node = new Node;
+		node->pred.store( Waiting, std::memory_order_relaxed );
+		return node;
+	} // get
+
+	static void put( Node *node ) {
+		Pool &p = pool();
+		node->free = p.head;
+		p.head = node;
+	} // put
+
+	alignas(CACHE_ALIGN) std::atomic<Node *> tail{ nullptr };
+	Node *holder;										// holder's node, only accessed in critical section
+
+	template<bool timed> bool acquire( Deadline *d ) {
+		Node *node = get();
+		Node *pred = tail.exchange( node, std::memory_order_acq_rel ); // fetch-and-store
+		while ( pred != nullptr ) {						// predecessor ?
+			Node *pp = pred->pred.load( std::memory_order_acquire );
+			if ( pp == &available ) {					// released
+				put( pred );
+				break;
+			} // if
+			if ( pp != Waiting ) {						// abandoned, skip
+				put( pred );
+				pred = pp;
+				continue;
+			} // if
+			if ( timed && d->expired() ) {				// abandon
+				Node *self = node;
+				if ( tail.compare_exchange_strong( self, pred, std::memory_order_acq_rel ) ) put( node ); // no successor ?
+				else node->pred.store( pred, std::memory_order_release ); // successor skips to my predecessor
+				return false;
+			} // if
+			Pause();
+		} // while
+		holder = node;
+		return true;
+	} // acquire
+  public:
+	static constexpr size_t words( unsigned int ) { return 2; } // shared words per instance
+
+	void lock() { acquire<false>( nullptr ); }
+	bool lock_until( Deadline &d ) { return acquire<true>( &d ); }
+
+	void unlock() {
+		Node *node = holder, *self = node;
+		if ( tail.compare_exchange_strong( self, nullptr, std::memory_order_acq_rel ) ) put( node ); // no successor ?
+		else node->pred.store( &available, std::memory_order_release ); // successor reclaims node
+	} // unlock
+}; // CLH
+
+//------------------------------------------------------------------------------
+
+// Leslie Lamport, A New Solution of Dijkstra's Concurrent Programming Problem, CACM, 17(8), 1974, p. 454
+// (LamportBakery.c).  An abandoned attempt withdraws its ticket.
+
+template<unsigned int Cap> class LamportBakery : public Timed<LamportBakery<Cap>> {
+	const unsigned int N;
+	alignas(CACHE_ALIGN) Word choosing[Cap];
+	alignas(CACHE_ALIGN) Word ticket[Cap];
+
+	TYPE doorway( TYPE id ) {							// select a ticket
+		choosing[id] = 1;
+		Fence();										// force store before more loads
+		TYPE max = 0;									// O(N) search for largest ticket
+		for ( unsigned int j = 0; j < N; j += 1 ) {
+			TYPE v = ticket[j];							// could change so must copy
+			if ( max < v ) max = v;
+		} // for
+		max += 1;										// advance ticket
+		ticket[id] = max;
+		choosing[id] = 0;
+		Fence();										// force store before more loads
+		return max;
+	} // doorway
+
+	bool ahead( TYPE j, TYPE id, TYPE max ) {			// j has priority ?
+		TYPE t = ticket[j];
+		return t != 0 && ( t < max || ( t == max && j < id ) );
+	} // ahead
+  public:
+	static constexpr size_t words( unsigned int n ) { return 2 * n; } // choosing, ticket
+
+	explicit LamportBakery( unsigned int n = Cap ) : N( n ) {}
+
+	void lock() {
+		TYPE id = slot( N ), max = doorway( id );
+		for ( unsigned int j = 0; j < N; j += 1 ) {		// check other tickets
+			LOCKS_AWAIT( choosing[j] == 0 );			// busy wait if thread selecting ticket
+			LOCKS_AWAIT( ! ahead( j, id, max ) );		// busy wait if greater ticket value or lower priority
+		} // for
+	} // lock
+
+	bool lock_until( Deadline &d ) {
+		TYPE id = slot( N ), max = doorway( id );
+		for ( unsigned int j = 0; j < N; j += 1 ) {
+			LOCKS_AWAIT( choosing[j] == 0 );			// doorway is wait-free, so bounded
+			while ( ahead( j, id, max ) ) {
+				if ( d.expired() ) {
+					ticket[id] = 0;						// withdraw
+					return false;
+				} // if
+				Pause();
+			} // while
+		} // for
+		return true;
+	} // lock_until
+
+	void unlock() {
+		ticket[slot( N )] = 0;
+	} // unlock
+}; // LamportBakery
+
+//------------------------------------------------------------------------------
+
+// Leslie Lamport, A Fast Mutual Exclusion Algorithm, ACM Transactions on Computer Systems, 5(1), 1987, Fig. 2, p. 5
+// (LamportFast.c).
+
+template<unsigned int Cap> class LamportFast {
+	const unsigned int N;
+	alignas(CACHE_ALIGN) Word b[Cap];
+	alignas(CACHE_ALIGN) Word x;
+	alignas(CACHE_ALIGN) Word y;						// size padded to alignment
+  public:
+	static constexpr size_t words( unsigned int n ) { return n + 2; } // b, x, y
+
+	explicit LamportFast( unsigned int n = Cap ) : N( n ), y( n ) {}
+
+	void lock() {
+		TYPE id = slot( N );
+	  start: b[id] = true;
+		x = id;
+		Fence();										// force store before more loads
+		if ( y != N ) {
+			b[id] = false;
+			Fence();									// force store before more loads
+			LOCKS_AWAIT( y == N );
+			goto start;
+		} // if
+		y = id;
+		Fence();										// force store before more loads
+		if ( x != id ) {
+			b[id] = false;
+			Fence();									// force store before more loads
+			for ( unsigned int j = 0; j < N; j += 1 )
+				LOCKS_AWAIT( ! b[j] );
+			if ( y != id ) goto start;
+		} // if
+	} // lock
+
+	void unlock() {
+		y = N;
+		b[slot( N )] = false;
+	} // unlock
+}; // LamportFast
+
+//------------------------------------------------------------------------------
+
+// Tournament trees (Tree.c): each slot walks a precomputed path of (match, position) steps from its leaf to the root,
+// and matches with a single contender are elided.  The paths are shared by all instances with the same N, so an
+// instance holds only its match data.  Node supplies the match algorithm:
+//   static constexpr unsigned int Words( degree )		words of match data
+//   static void prologue( Word *x, unsigned int es, unsigned int ws )
+//   static void epilogue( Word *x, unsigned int es, unsigned int ws )
+
+template<unsigned int Cap, unsigned int Degree, typename Node> class Tree {
+	static_assert( Degree >= 2, "tree degree must be at least 2" );
+	static constexpr unsigned int Stride = (Node::Words( Degree ) * sizeof(Word) + CACHE_ALIGN - 1) / CACHE_ALIGN * CACHE_ALIGN / sizeof(Word);
+
+	struct Step {
+		unsigned int offset;							// match data, word offset in nodes
+		unsigned short int es;							// position of contender within match
+		unsigned short int ws;							// number of contenders at match
+	}; // Step
+
+	struct Paths {										// identical for all instances with the same N
+		Step steps[Cap][Clog2( Cap ) > 0 ? Clog2( Cap ) : 1];
+		unsigned int heights[Cap];
+	}; // Paths
+
+	static const Paths *table( unsigned int n ) {		// shared paths for n threads, built on first use
+		static std::atomic<Paths *> tables[Cap + 1];	// no mutex, as pthread mutexes may be replaced by these locks
+		Paths *p = tables[n].load( std::memory_order_acquire );
+	  if ( p != nullptr ) return p;
+		p = new Paths;
+		// Only the last node of a level can be partial, and it is elided when it has a single contender.
+		for ( unsigned int id = 0; id < n; id += 1 ) {
+			unsigned int l = id, h = 0, base = 0;		// base is first match of level
+			for ( unsigned int m = n; m > 1; m = (m + Degree - 1) / Degree ) {
+				unsigned int k = l / Degree;			// node at this level
+				unsigned int ws = m - k * Degree < Degree ? m - k * Degree : Degree;
+				if ( ws > 1 ) {							// match to play ?
+					p->steps[id][h] = Step{ (base + k) * Stride, (unsigned short int)(l % Degree), (unsigned short int)ws };
+					h += 1;
+				} // if
+				base += m / Degree + (m % Degree > 1);
+				l = k;
+			} // for
+			p->heights[id] = h;
+		} // for
+		Paths *empty = nullptr;
+		if ( ! tables[n].compare_exchange_strong( empty, p, std::memory_order_acq_rel ) ) { // another thread built it ?
+			delete p;
+			p = empty;
+		} // if
+		return p;
+	} // table
+
+	alignas(CACHE_ALIGN) Word nodes[MaxMatches( Cap ) * Stride]; // each match on its own cache lines
+	const Paths *paths;
+  protected:
+	const unsigned int N;
+
+	void prologue( TYPE id ) {							// leaf to root
+		for ( unsigned int h = 0; h < paths->heights[id]; h += 1 ) {
+			const Step &s = paths->steps[id][h];
+			Node::prologue( &nodes[s.offset], s.es, s.ws );
+		} // for
+	} // prologue
+
+	void epilogue( TYPE id, unsigned int height ) {		// matches below height, root to leaf
+		for ( unsigned int h = height; h > 0; h -= 1 ) {
+			const Step &s = paths->steps[id][h - 1];
+			Node::epilogue( &nodes[s.offset], s.es, s.ws );
+		} // for
+	} // epilogue
+
+	void epilogue( TYPE id ) {
+		epilogue( id, paths->heights[id] );
+	} // epilogue
+
+	bool prologue( TYPE id, Deadline &d ) {				// leaf to root, false => path unwound
+		for ( unsigned int h = 0; h < paths->heights[id]; h += 1 ) {
+			const Step &s = paths->steps[id][h];
+			if ( ! Node::prologue( &nodes[s.offset], s.es, s.ws, d ) ) { // match retracted ?
+				epilogue( id, h );						// release won matches
+				return false;
+			} // if
+		} // for
+		return true;
+	} // prologue
+  public:
+	static constexpr size_t words( unsigned int n ) {	// match data of existing matches
+		size_t w = 0;
+		for ( unsigned int m = n; m > 1; m = (m + Degree - 1) / Degree ) w += (m / Degree + (m % Degree > 1)) * Node::Words( Degree );
+		return w;
+	} // words
+
+	explicit Tree( unsigned int n = Cap ) : paths( table( n ) ), N( n ) {}
+
+	unsigned int height( TYPE id ) const { return paths->heights[id]; }
+}; // Tree
+
+// Gary L. Peterson, Myths About the Mutual Exclusion Problem, Information Processing Letters, 12(3), 1981, p. 115,
+// as the 2-thread match of a binary tree (Binary.c).  Retracting is the exit protocol, so abandoning a match is safe.
+struct PetersonNode {
+	static constexpr unsigned int Words( unsigned int ) { return 3; } // Q[2], R
+
+	static void prologue( Word *t, unsigned int c, unsigned int ) {
+		unsigned int other = c ^ 1;
+		t[c] = 1;
+		t[2] = c;										// RACE
+		Fence();										// force store before more loads
+		LOCKS_AWAIT( ! ( t[other] && t[2] == c ) );		// busy wait
+	} // prologue
+
+	static bool prologue( Word *t, unsigned int c, unsigned int, Deadline &d ) { // false => retracted
+		unsigned int other = c ^ 1;
+		t[c] = 1;
+		t[2] = c;										// RACE
+		Fence();										// force store before more loads
+		while ( t[other] && t[2] == c ) {
+			if ( d.expired() ) {
+				t[c] = 0;								// retract
+				return false;
+			} // if
+			Pause();
+		} // while
+		return true;
+	} // prologue
+
+	static void epilogue( Word *t, unsigned int c, unsigned int ) {
+		t[c] = 0;
+	} // epilogue
+}; // PetersonNode
+
+// Zhang, Yan and Castaneda d-thread match (Tree.c ZHANG), which is Lamport's retract algorithm (LamportRetract.c) for
+// ws threads: a contender retracts while a higher-priority contender is present, then waits for lower-priority
+// contenders to leave.  A lower-priority contender defers to a declared intent, so retracting it abandons the match.
+struct ZhangNode {
+	static constexpr unsigned int Words( unsigned int degree ) { return degree; } // intent flags
+
+	static void prologue( Word *x, unsigned int es, unsigned int ws ) {
+	  L: x[es] = 1;										// declare intent
+		Fence();										// force store before more loads
+		for ( unsigned int i = 0; i < es; i += 1 ) {	// higher priority contender ?
+			if ( x[i] ) {
+				x[es] = 0;								// retract intent
+				Fence();								// force store before more loads
+				LOCKS_AWAIT( x[i] == 0 );
+				goto L;
+			} // if
+		} // for
+		for ( unsigned int i = es + 1; i < ws; i += 1 )	// wait for lower priority contenders to leave
+			LOCKS_AWAIT( x[i] == 0 );
+	} // prologue
+
+	static bool prologue( Word *x, unsigned int es, unsigned int ws, Deadline &d ) { // false => retracted
+	  L: x[es] = 1;										// declare intent
+		Fence();										// force store before more loads
+		for ( unsigned int i = 0; i < es; i += 1 ) {	// higher priority contender ?
+			if ( x[i] ) {
+				x[es] = 0;								// retract intent
+				Fence();								// force store before more loads
+				while ( x[i] != 0 ) {
+				  if ( d.expired() ) return false;
+					Pause();
+				} // while
+				goto L;
+			} // if
+		} // for
+		for ( unsigned int i = es + 1; i < ws; i += 1 ) { // wait for lower priority contenders to leave
+			while ( x[i] != 0 ) {
+				if ( d.expired() ) {
+					x[es] = 0;							// retract intent
+					return false;
+				} // if
+				Pause();
+			} // while
+		} // for
+		return true;
+	} // prologue
+
+	static void epilogue( Word *x, unsigned int es, unsigned int ) {
+		x[es] = 0;
+	} // epilogue
+}; // ZhangNode
+
+// Gadi Taubenfeld, Synchronization Algorithms and Concurrent Programming, 2006, Section 2.4.2, with Buhr's elided
+// matches (TaubenfeldBuhr.c): binary tournament of Peterson matches.
+
+template<unsigned int Cap> class TaubenfeldBuhr : public Tree<Cap, 2, PetersonNode>, public Timed<TaubenfeldBuhr<Cap>> {
+	typedef Tree<Cap, 2, PetersonNode> Base;
+  public:
+	explicit TaubenfeldBuhr( unsigned int n = Cap ) : Base( n ) {}
+	void lock() { Base::prologue( slot( Base::N ) ); }
+	bool lock_until( Deadline &d ) { return Base::prologue( slot( Base::N ), d ); }
+	void unlock() { Base::epilogue( slot( Base::N ) ); }
+}; // TaubenfeldBuhr
+
+// Zhang, Yan and Castaneda d-ary tournament (ZhangdT.c).
+
+template<unsigned int Cap, unsigned int Degree = 2> class ZhangdT : public Tree<Cap, Degree, ZhangNode>, public Timed<ZhangdT<Cap, Degree>> {
+	typedef Tree<Cap, Degree, ZhangNode> Base;
+  public:
+	explicit ZhangdT( unsigned int n = Cap ) : Base( n ) {}
+	void lock() { Base::prologue( slot( Base::N ) ); }
+	bool lock_until( Deadline &d ) { return Base::prologue( slot( Base::N ), d ); }
+	void unlock() { Base::epilogue( slot( Base::N ) ); }
+}; // ZhangdT
+
+//------------------------------------------------------------------------------
+
+// Leslie Lamport, The Mutual Exclusion Problem: Part II - Statement and Solutions, Journal of the ACM, 33(2), 1986,
+// Fig. 1, p. 337 (LamportRetract.c): a single Zhang match of N threads.
+
+template<unsigned int Cap> class LamportRetract : public Timed<LamportRetract<Cap>> {
+	const unsigned int N;
+	alignas(CACHE_ALIGN) Word intents[Cap];
+  public:
+	static constexpr size_t words( unsigned int n ) { return n; }
+
+	explicit LamportRetract( unsigned int n = Cap ) : N( n ) {}
+	void lock() { ZhangNode::prologue( intents, slot( N ), N ); }
+	bool lock_until( Deadline &d ) { return ZhangNode::prologue( intents, slot( N ), N, d ); }
+	void unlock() { ZhangNode::epilogue( intents, slot( N ), N ); }
+}; // LamportRetract
+
+// James E. Burns and Nancy A. Lynch, Mutual Exclusion using Indivisible Reads and Writes, Proceedings of the 18th
+// Annual Allerton Conference on Communications, Control and Computing, 1980, p. 836 (BurnsLynchRetract.c).  An
+// intent is only declared after lower ids are seen out, and clearing it abandons the attempt at any point.
+
+template<unsigned int Cap> class BurnsLynch : public Timed<BurnsLynch<Cap>> {
+	enum Intent { DontWantIn, WantIn };
+	const unsigned int N;
+	alignas(CACHE_ALIGN) Word intents[Cap];
+
+	template<bool timed> bool acquire( TYPE id, Deadline *d ) {
+	  L0: intents[id] = DontWantIn;
+		Fence();										// force store before more loads
+		for ( unsigned int j = 0; j < id; j += 1 ) {
+			if ( intents[j] == WantIn ) {
+			  if ( timed && d->expired() ) return false;
+				Pause();
+				goto L0;
+			} // if
+		} // for
+		intents[id] = WantIn;
+		Fence();										// force store before more loads
+		for ( unsigned int j = 0; j < id; j += 1 )
+			if ( intents[j] == WantIn ) goto L0;
+	  L1: for ( unsigned int j = id + 1; j < N; j += 1 ) {
+			if ( intents[j] == WantIn ) {
+				if ( timed && d->expired() ) {
+					intents[id] = DontWantIn;			// retract
+					return false;
+				} // if
+				Pause();
+				goto L1;
+			} // if
+		} // for
+		return true;
+	} // acquire
+  public:
+	static constexpr size_t words( unsigned int n ) { return n; }
+
+	explicit BurnsLynch( unsigned int n = Cap ) : N( n ) {}
+	void lock() { acquire<false>( slot( N ), nullptr ); }
+	bool lock_until( Deadline &d ) { return acquire<true>( slot( N ), &d ); }
+	void unlock() { intents[slot( N )] = DontWantIn; }
+}; // BurnsLynch
+
+//------------------------------------------------------------------------------
+
+// Wim H. Hesselink, Peter A. Buhr and David Dice, Fast Mutual Exclusion by the Triangle Algorithm (Triangle.c,
+// FastPath.c): the winner of Lamport's fast path plays side 1 of a 2-thread arbiter, everyone else plays side 0 after
+// winning the TaubenfeldBuhr tree.  Which side the holder played is only accessed in the critical section.
+
+template<unsigned int Cap> class Triangle {
+	const unsigned int N;
+	TaubenfeldBuhr<Cap> tree;
+	alignas(CACHE_ALIGN) Word b[Cap];
+	alignas(CACHE_ALIGN) Word x;
+	alignas(CACHE_ALIGN) Word y;
+	alignas(CACHE_ALIGN) Word arbiter[PetersonNode::Words( 2 )]; // fast (1) versus slow (0) winner
+	alignas(CACHE_ALIGN) unsigned int side;				// holder's arbiter side
+
+	bool fast( TYPE id ) {								// true => won fast path
+	  if ( y != N ) return false;
+		b[id] = true;
+		x = id;
+		Fence();										// force store before more loads
+		if ( y != N ) {
+			b[id] = false;
+			return false;
+		} // if
+		y = id;
+		Fence();										// force store before more loads
+		if ( x != id ) {
+			b[id] = false;
+			Fence();									// force store before more loads
+			for ( unsigned int j = 0; y == id && j < N; j += 1 )
+				LOCKS_AWAIT( ! b[j] );
+		  if ( y != id ) return false;
+		} // if
+		return true;
+	} // fast
+  public:
+	static constexpr size_t words( unsigned int n ) { return TaubenfeldBuhr<Cap>::words( n ) + n + 2 + PetersonNode::Words( 2 ) + 1; }
+
+	explicit Triangle( unsigned int n = Cap ) : N( n ), tree( n ), y( n ) {}
+
+	void lock() {
+		TYPE id = slot( N );
+		unsigned int c = fast( id );
+		if ( c == 0 ) tree.lock();
+		PetersonNode::prologue( arbiter, c, 2 );
+		side = c;
+	} // lock
+
+	void unlock() {
+		unsigned int c = side;
+		PetersonNode::epilogue( arbiter, c, 2 );
+		if ( c == 1 ) {
+			y = N;
+			b[slot( N )] = false;
+		} else {
+			tree.unlock();
+		} // if
+	} // unlock
+}; // Triangle
+
+//------------------------------------------------------------------------------
+
+// Elevator algorithm with a circular queue of waiting threads (ElevatorQueue.c -DCAS -DFLAG): the leader, elected by
+// CAS, waits for the critical section to be free, while the releasing thread scans a tree of recent arrivals for
+// applicants, queues them and passes the critical section to the queue head.
+
+template<unsigned int Cap> class ElevatorQueue {
+	struct alignas(CACHE_ALIGN) Tstate {				// performance gain when fields juxtaposed
+		Word apply, flag;
+	}; // Tstate
+
+	const unsigned int N;
+	alignas(CACHE_ALIGN) Word fast;
+	Tstate tstate[Cap + 1];
+	alignas(CACHE_ALIGN) Word val[2 * Cap];
+	alignas(CACHE_ALIGN) TYPE elements[Cap];			// queue only accessed in critical section
+	unsigned int front = 0, rear = 0;
+
+	TYPE cycleUp( TYPE v ) { return v >= N - 1 ? 0 : v + 1; }
+  public:
+	static constexpr size_t words( unsigned int n ) { return 1 + 2 * (n + 1) + 2 * n + n + 2; } // fast, tstate, val, queue
+
+	explicit ElevatorQueue( unsigned int n = Cap ) : N( n ) {
+		for ( unsigned int id = 0; id < N; id += 1 ) {	// initialize shared data
+			val[id] = N;
+			val[N + id] = id;
+		} // for
+		tstate[N].flag = true;
+	} // ElevatorQueue
+
+	void lock() {
+		TYPE id = slot( N );
+		tstate[id].apply = true;
+		for ( unsigned int j = (N + id) >> 1; j > 1; j >>= 1 ) // parent of leaf to child of root
+			val[j] = id;
+		if ( fast.cas( false, true ) ) {				// true => leader
+			LOCKS_AWAIT( tstate[id].flag || tstate[N].flag );
+			tstate[N].flag = false;
+			fast = false;
+		} else {
+			LOCKS_AWAIT( tstate[id].flag );
+		} // if
+		tstate[id].flag = false;
+		tstate[id].apply = false;
+	} // lock
+
+	void unlock() {
+		const unsigned int n = N + slot( N );
+		for ( int j = Log2( n ) - 1; j >= 0; j -= 1 ) { // child of root to leaf, inspecting siblings
+			TYPE k = val[(n >> j) ^ 1];
+			if ( tstate[k].apply ) {
+				tstate[k].apply = false;
+				elements[rear] = k;						// enqueue
+				rear = cycleUp( rear );
+			} // if
+		} // for
+		if ( front != rear ) {
+			TYPE k = elements[front];					// dequeue
+			front = cycleUp( front );
+			tstate[k].flag = true;
+		} else {
+			tstate[N].flag = true;
+		} // if
+	} // unlock
+}; // ElevatorQueue
+
+//------------------------------------------------------------------------------
+
+// Always-on contention statistics in the style of Linux lockstat for any lock L used by at most Cap threads, e.g.:
+//   static locks::Stat<locks::MCS, 64> m;				// lock/unlock/try_lock as MCS
+//   locks::LockStat s = m.snapshot();
+// Every acquisition is counted, and every Sample'th acquisition of a thread is timed: the wait from arrival to
+// acquisition, whether it was contended (L's first try_lock failed, so only known for a Lockable L; otherwise
+// LockStat::contentionKnown is false and contention is unavailable, not 0), and the hold until release.  Each thread accumulates into its own cache line of the instance, indexed by slot, so the statistics add no
+// shared writes, and an unsampled acquisition costs a load and store of the thread's count.  snapshot() sums the lines
+// with relaxed loads while the threads run, so it never delays them but is only consistent when they are idle.  Times
+// are ticks, TSC cycles on x86 and nanoseconds elsewhere.
+
+#ifndef LOCKS_SAMPLE
+#define LOCKS_SAMPLE 64									// time every 64th acquisition of a thread
+#endif // ! LOCKS_SAMPLE
+
+struct LockStat {
+	uint64_t acquisitions = 0;							// exact
+	uint64_t samples = 0, contended = 0;				// timed acquisitions, and those contended
+	uint64_t wait = 0, hold = 0, maxwait = 0;			// sampled ticks
+	unsigned int waiter = ~0u;							// slot of longest sampled wait, ~0u => none
+	bool contentionKnown = true;						// false => lock without try_lock, contended not counted
+
+	double contention() const {							// fraction contended, 0 when unknown
+		return samples == 0 || ! contentionKnown ? 0.0 : (double)contended / samples;
+	} // contention
+	double avgwait() const { return samples == 0 ? 0.0 : (double)wait / samples; }
+	double avghold() const { return samples == 0 ? 0.0 : (double)hold / samples; }
+
+	LockStat &operator+=( const LockStat &s ) {			// combine instances, e.g., stripes
+		acquisitions += s.acquisitions;
+		samples += s.samples;
+		contended += s.contended;
+		wait += s.wait;
+		hold += s.hold;
+		contentionKnown = contentionKnown && s.contentionKnown;
+		if ( s.maxwait > maxwait ) { maxwait = s.maxwait; waiter = s.waiter; }
+		return *this;
+	} // operator+=
+}; // LockStat
+
+template<typename L, unsigned int Cap, unsigned int Sample = LOCKS_SAMPLE> class Stat {
+	static_assert( Sample != 0 && (Sample & (Sample - 1)) == 0, "Sample must be a power of 2" );
+
+	template<typename T, typename = void> struct Try : std::false_type {};
+	template<typename T> struct Try<T, std::void_t<decltype( std::declval<T &>().try_lock() )>> : std::true_type {};
+
+	struct alignas(CACHE_ALIGN) Counts {				// only written by the thread with the slot
+		std::atomic<uint64_t> acquisitions{ 0 }, samples{ 0 }, contended{ 0 }, wait{ 0 }, hold{ 0 }, maxwait{ 0 };
+		uint64_t start = 0;								// sampled acquisition time, 0 => hold not sampled
+	}; // Counts
+
+	L l;
+	Counts counts[Cap];
+
+	static uint64_t now() {
+#if defined( __i386 ) || defined( __x86_64 )
+		return __builtin_ia32_rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+#endif
+	} // now
+
+	static void add( std::atomic<uint64_t> &c, uint64_t v ) { // single writer, no atomic read-modify-write
+		c.store( c.load( std::memory_order_relaxed ) + v, std::memory_order_relaxed );
+	} // add
+
+	static bool sample( Counts &c ) {					// count acquisition, true => time it
+		uint64_t a = c.acquisitions.load( std::memory_order_relaxed );
+		c.acquisitions.store( a + 1, std::memory_order_relaxed );
+		return a % Sample == 0;
+	} // sample
+
+	static void acquired( Counts &c, uint64_t arrive, bool contended ) {
+		c.start = now();
+		uint64_t wait = c.start - arrive;
+		add( c.samples, 1 );
+		add( c.contended, contended );
+		add( c.wait, wait );
+		if ( wait > c.maxwait.load( std::memory_order_relaxed ) ) c.maxwait.store( wait, std::memory_order_relaxed );
+	} // acquired
+  public:
+	template<typename... Args> Stat( Args... args ) : l( args... ) {}
+
+	static constexpr size_t words( unsigned int n ) { return L::words( n ); } // statistics are not shared words
+
+	void lock() {
+		Counts &c = counts[slot( Cap )];
+	  if ( __builtin_expect( ! sample( c ), true ) ) { l.lock(); return; }
+		uint64_t arrive = now();
+		bool contended = false;
+		if constexpr ( Try<L>::value ) {
+			if ( ! l.try_lock() ) {						// fast path failed ?
+				contended = true;
+				l.lock();
+			} // if
+		} else {
+			l.lock();
+		} // if
+		acquired( c, arrive, contended );
+	} // lock
+
+	template<typename T = L, typename = std::enable_if_t<Try<T>::value>> bool try_lock() {
+		Counts &c = counts[slot( Cap )];
+		uint64_t arrive = now();
+	  if ( ! l.try_lock() ) return false;
+		if ( sample( c ) ) acquired( c, arrive, false );
+		return true;
+	} // try_lock
+
+	void unlock() {
+		Counts &c = counts[slot()];						// checked on acquisition
+		if ( c.start != 0 ) {							// sampled hold ?
+			add( c.hold, now() - c.start );
+			c.start = 0;
+		} // if
+		l.unlock();
+	} // unlock
+
+	LockStat snapshot() const {
+		LockStat s;
+		s.contentionKnown = Try<L>::value;
+		for ( unsigned int i = 0; i < Cap; i += 1 ) {
+			const Counts &c = counts[i];
+			s.acquisitions += c.acquisitions.load( std::memory_order_relaxed );
+			s.samples += c.samples.load( std::memory_order_relaxed );
+			s.contended += c.contended.load( std::memory_order_relaxed );
+			s.wait += c.wait.load( std::memory_order_relaxed );
+			s.hold += c.hold.load( std::memory_order_relaxed );
+			uint64_t maxwait = c.maxwait.load( std::memory_order_relaxed );
+			if ( maxwait > s.maxwait ) { s.maxwait = maxwait; s.waiter = i; }
+		} // for
+		return s;
+	} // snapshot
+}; // Stat
+
+#undef LOCKS_AWAIT
+
+} // namespace locks
+
+#endif // LOCKS_H
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-mode: "c++-mode" //
+// End: //
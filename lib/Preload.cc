@@ -0,0 +1,291 @@
+// LD_PRELOAD shim replacing pthread mutexes in an unmodified program by a lib/Locks.h algorithm chosen at compile
+// time, e.g.:
+//
+//   g++ -std=c++17 -Wall -O3 -DNDEBUG -fPIC -shared -DLOCK='TaubenfeldBuhr<CAP>' lib/Preload.cc -ldl -o libTB.so
+//   LD_PRELOAD=./libTB.so program ...
+//
+// LOCK is a Lockable algorithm (with try_lock, see Locks.h): SpinLock, MCS, CLH, LamportBakery<CAP>,
+// LamportRetract<CAP>, BurnsLynch<CAP>, TaubenfeldBuhr<CAP> or ZhangdT<CAP, d>, where CAP (default 64) bounds the
+// threads holding slots at once.  An algorithm without try_lock (LamportFast, Triangle, ElevatorQueue) is rejected at
+// compile time, as trylock would block and trylock-based deadlock avoidance could deadlock.  pthread_mutex_lock, unlock,
+// trylock and timedlock are interposed, and each mutex is lazily mapped to its own lock instance through an address
+// table of LOCKS_MUTEXES entries, created on first use.  Threads are registered automatically by the slot allocator.
+// Recursive, error-checking, robust, priority-inheritance/protect and process-shared mutexes, and mutexes beyond a
+// full table, fall back to the real pthread implementation.
+//
+// A condition wait on a replaced mutex cannot release the lock atomically, so it holds the (otherwise unused) pthread
+// mutex itself while releasing the lock and waiting, and a signal or broadcast on the condition takes that pthread
+// mutex first, so a waiter between releasing the lock and waiting cannot miss the wakeup.  A condition is associated
+// with the mutex of its first waiter, so a condition must not be used with different replaced mutexes.  Timedlock polls
+// try_lock until the deadline.
+//
+// At exit, per-mutex statistics are written to stderr, or to the file named by environment variable LOCKS_STATS,
+// sorted by total wait: acquisitions, contended acquisitions (lock held on arrival), trylock attempts and failures,
+// and total and maximum wait in TSC cycles.  Statistics are only updated by the holder, so they add no shared writes
+// outside the critical section.  Running harness PthreadLock.c with and without the shim gives an A/B comparison with
+// the harness algorithms.
+
+#include "Locks.h"
+#include <algorithm>									// sort
+#include <cerrno>										// EBUSY, ETIMEDOUT
+#include <ctime>										// clock_gettime
+#include <dlfcn.h>										// dlsym, dlvsym
+#include <pthread.h>
+#include <type_traits>
+#include <vector>
+#include <x86intrin.h>									// __rdtsc
+
+using namespace locks;
+
+#ifndef CAP
+#define CAP 64
+#endif // ! CAP
+
+#ifndef LOCK
+#define LOCK MCS
+#endif // ! LOCK
+
+#ifndef LOCKS_MUTEXES
+#define LOCKS_MUTEXES (1 << 16)							// power of 2
+#endif // ! LOCKS_MUTEXES
+
+#define xstr(...) str(__VA_ARGS__)						// LOCK may contain commas
+#define str(...) #__VA_ARGS__
+
+typedef LOCK Lock;
+
+template<typename L, typename = void> struct Lockable : std::false_type {};
+template<typename L> struct Lockable<L, std::void_t<decltype( std::declval<L &>().try_lock() )>> : std::true_type {};
+static_assert( Lockable<Lock>::value, "LOCK must provide try_lock, so pthread_mutex_trylock and timedlock cannot block" );
+
+struct State {
+	Lock lock;
+	Word held;											// holder present, contention hint
+	uint64_t locks = 0, contended = 0, trylocks = 0, wait = 0, maxwait = 0; // only written by holder
+	std::atomic<uint64_t> tryfails{ 0 };				// written by failing threads
+}; // State
+
+// Open-addressing table from an address to a lazily created value, insert only.  A key is claimed by CAS, and a
+// prober finding its key spins until the claimer publishes the value.
+
+template<typename K, typename V> class Table {
+	struct Entry {
+		std::atomic<K *> key{ nullptr };
+		std::atomic<V *> value{ nullptr };
+	}; // Entry
+	Entry entries[LOCKS_MUTEXES];
+  public:
+	template<typename Make> V *find( K *k, bool create, Make make ) { // nullptr => absent or table full
+		size_t h = ((uintptr_t)k >> 4) * 0x9E3779B97F4A7C15ull >> 16;
+		for ( unsigned int p = 0; p < LOCKS_MUTEXES; p += 1 ) {
+			Entry &e = entries[(h + p) & (LOCKS_MUTEXES - 1)];
+			K *key = e.key.load( std::memory_order_acquire );
+			if ( key == nullptr ) {
+			  if ( ! create ) return nullptr;
+				if ( e.key.compare_exchange_strong( key, k, std::memory_order_acq_rel ) ) {
+					V *v = make();
+					e.value.store( v, std::memory_order_release );
+					return v;
+				} // if
+			} // if
+			if ( key == k ) {
+				V *v;
+				while ( (v = e.value.load( std::memory_order_acquire )) == nullptr ) Pause(); // being created
+				return v;
+			} // if
+		} // for
+		return nullptr;
+	} // find
+
+	template<typename F> void each( F f ) {
+		for ( Entry &e : entries ) {
+			V *v = e.value.load( std::memory_order_acquire );
+			if ( v != nullptr ) f( e.key.load( std::memory_order_relaxed ), v );
+		} // for
+	} // each
+}; // Table
+
+static Table<pthread_mutex_t, State> *mutexes;
+static Table<pthread_cond_t, pthread_mutex_t> *conds;	// condition to replaced mutex of its waiters
+
+static int (*real_mutex_lock)( pthread_mutex_t * );
+static int (*real_mutex_unlock)( pthread_mutex_t * );
+static int (*real_mutex_trylock)( pthread_mutex_t * );
+static int (*real_mutex_timedlock)( pthread_mutex_t *, const struct timespec * );
+static int (*real_cond_wait)( pthread_cond_t *, pthread_mutex_t * );
+static int (*real_cond_timedwait)( pthread_cond_t *, pthread_mutex_t *, const struct timespec * );
+static int (*real_cond_signal)( pthread_cond_t * );
+static int (*real_cond_broadcast)( pthread_cond_t * );
+
+template<typename F> static void resolve( F &f, const char *name, const char *version = nullptr ) {
+	void *p = version == nullptr ? dlsym( RTLD_NEXT, name ) : dlvsym( RTLD_NEXT, name, version );
+	if ( p == nullptr ) {
+		fprintf( stderr, "locks: cannot find %s\n", name );
+		abort();
+	} // if
+	f = (F)p;
+} // resolve
+
+static void __attribute__(( constructor )) init() {
+  if ( mutexes != nullptr ) return;						// already initialized
+	resolve( real_mutex_lock, "pthread_mutex_lock" );
+	resolve( real_mutex_unlock, "pthread_mutex_unlock" );
+	resolve( real_mutex_trylock, "pthread_mutex_trylock" );
+	resolve( real_mutex_timedlock, "pthread_mutex_timedlock" );
+	resolve( real_cond_wait, "pthread_cond_wait", "GLIBC_2.3.2" ); // not the old condition variables
+	resolve( real_cond_timedwait, "pthread_cond_timedwait", "GLIBC_2.3.2" );
+	resolve( real_cond_signal, "pthread_cond_signal", "GLIBC_2.3.2" );
+	resolve( real_cond_broadcast, "pthread_cond_broadcast", "GLIBC_2.3.2" );
+	conds = new Table<pthread_cond_t, pthread_mutex_t>;
+	mutexes = new Table<pthread_mutex_t, State>;		// last, marks initialized
+} // init
+
+static State *state( pthread_mutex_t *m ) {				// nullptr => real pthread mutex
+	if ( mutexes == nullptr ) init();					// called before constructors
+	int kind = m->__data.__kind & 0xff;					// glibc type, robust, protocol and process-shared bits
+  if ( kind != PTHREAD_MUTEX_TIMED_NP && kind != PTHREAD_MUTEX_ADAPTIVE_NP ) return nullptr;
+	return mutexes->find( m, true, []{ return new State; } );
+} // state
+
+static inline void acquired( State *s, uint64_t start, bool contended ) { // holder updates statistics
+	uint64_t wait = __rdtsc() - start;
+	s->held = 1;
+	s->locks += 1;
+	s->contended += contended;
+	s->wait += wait;
+	if ( wait > s->maxwait ) s->maxwait = wait;
+} // acquired
+
+static inline bool attempt( Lock &lock, State *s ) {
+  if ( s->held != 0 ) return false;						// also fails for holder, whose attempt would succeed
+	return lock.try_lock();
+} // attempt
+
+static inline bool acquire( Lock &lock, const struct timespec *abstime ) { // false => timeout
+	for ( unsigned int i = 0; ! lock.try_lock(); i += 1 ) { // poll until deadline
+		if ( i % 64 == 0 ) {
+			struct timespec now;
+			clock_gettime( CLOCK_REALTIME, &now );
+		  if ( now.tv_sec > abstime->tv_sec || ( now.tv_sec == abstime->tv_sec && now.tv_nsec >= abstime->tv_nsec ) ) return false;
+		} // if
+		Pause();
+	} // for
+	return true;
+} // acquire
+
+static int condWait( pthread_cond_t *c, pthread_mutex_t *m, const struct timespec *abstime ) { // abstime nullptr => wait
+	State *s = state( m );
+  if ( s == nullptr ) return abstime == nullptr ? real_cond_wait( c, m ) : real_cond_timedwait( c, m, abstime );
+	conds->find( c, true, [m]{ return m; } );			// signallers of c take m
+	real_mutex_lock( m );								// before releasing lock, so no wakeup is missed
+	s->held = 0;
+	s->lock.unlock();
+	int rc = abstime == nullptr ? real_cond_wait( c, m ) : real_cond_timedwait( c, m, abstime );
+	real_mutex_unlock( m );
+	bool contended = s->held != 0;
+	uint64_t start = __rdtsc();
+	s->lock.lock();
+	acquired( s, start, contended );
+	return rc;
+} // condWait
+
+extern "C" {
+
+int pthread_mutex_lock( pthread_mutex_t *m ) {
+	State *s = state( m );
+  if ( s == nullptr ) return real_mutex_lock( m );
+	bool contended = s->held != 0;
+	uint64_t start = __rdtsc();
+	s->lock.lock();
+	acquired( s, start, contended );
+	return 0;
+} // pthread_mutex_lock
+
+int pthread_mutex_trylock( pthread_mutex_t *m ) {
+	State *s = state( m );
+  if ( s == nullptr ) return real_mutex_trylock( m );
+	bool won = attempt( s->lock, s );
+	if ( ! won ) {
+		s->tryfails.fetch_add( 1, std::memory_order_relaxed );
+		return EBUSY;
+	} // if
+	acquired( s, __rdtsc(), false );
+	s->trylocks += 1;
+	return 0;
+} // pthread_mutex_trylock
+
+int pthread_mutex_timedlock( pthread_mutex_t *m, const struct timespec *abstime ) {
+	State *s = state( m );
+  if ( s == nullptr ) return real_mutex_timedlock( m, abstime );
+	bool contended = s->held != 0;
+	uint64_t start = __rdtsc();
+	if ( ! acquire( s->lock, abstime ) ) return ETIMEDOUT;
+	acquired( s, start, contended );
+	return 0;
+} // pthread_mutex_timedlock
+
+int pthread_mutex_unlock( pthread_mutex_t *m ) {
+	State *s = state( m );
+  if ( s == nullptr ) return real_mutex_unlock( m );
+	s->held = 0;
+	s->lock.unlock();
+	return 0;
+} // pthread_mutex_unlock
+
+int pthread_cond_timedwait( pthread_cond_t *c, pthread_mutex_t *m, const struct timespec *abstime ) {
+	return condWait( c, m, abstime );
+} // pthread_cond_timedwait
+
+int pthread_cond_wait( pthread_cond_t *c, pthread_mutex_t *m ) {
+	return condWait( c, m, nullptr );
+} // pthread_cond_wait
+
+int pthread_cond_signal( pthread_cond_t *c ) {
+	if ( mutexes == nullptr ) init();
+	pthread_mutex_t *m = conds->find( c, false, []{ return nullptr; } );
+  if ( m == nullptr ) return real_cond_signal( c );
+	real_mutex_lock( m );								// waiter is waiting or has not yet released lock
+	int rc = real_cond_signal( c );
+	real_mutex_unlock( m );
+	return rc;
+} // pthread_cond_signal
+
+int pthread_cond_broadcast( pthread_cond_t *c ) {
+	if ( mutexes == nullptr ) init();
+	pthread_mutex_t *m = conds->find( c, false, []{ return nullptr; } );
+  if ( m == nullptr ) return real_cond_broadcast( c );
+	real_mutex_lock( m );
+	int rc = real_cond_broadcast( c );
+	real_mutex_unlock( m );
+	return rc;
+} // pthread_cond_broadcast
+
+} // extern "C"
+
+static void __attribute__(( destructor )) stats() {
+  if ( mutexes == nullptr ) return;
+	std::vector<std::pair<pthread_mutex_t *, State *>> used;
+	mutexes->each( [&used]( pthread_mutex_t *m, State *s ) { if ( s->locks + s->tryfails != 0 ) used.emplace_back( m, s ); } );
+	std::sort( used.begin(), used.end(), []( auto &a, auto &b ) { return a.second->wait > b.second->wait; } );
+
+	const char *name = getenv( "LOCKS_STATS" );
+	FILE *out = name == nullptr ? stderr : fopen( name, "w" );
+	if ( out == nullptr ) {
+		perror( name );
+		return;
+	} // if
+	fprintf( out, "lock:%s mutexes:%zu\n", xstr(LOCK), used.size() );
+	fprintf( out, "%-18s %12s %12s %12s %12s %16s %14s\n", "mutex", "locks", "contended", "trylocks", "tryfails", "wait", "maxwait" );
+	for ( auto &u : used ) {
+		State *s = u.second;
+		uint64_t tryfails = s->tryfails;
+		fprintf( out, "%-18p %12ju %12ju %12ju %12ju %16ju %14ju\n", (void *)u.first, s->locks, s->contended, s->trylocks + tryfails, tryfails, s->wait, s->maxwait );
+	} // for
+	if ( out != stderr ) fclose( out );
+} // stats
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-mode: "c++-mode" //
+// compile-command: "g++ -Wall -std=c++17 -O3 -DNDEBUG -fPIC -shared -DLOCK=MCS Preload.cc -ldl -o libMCS.so" //
+// End: //
@@ -0,0 +1,212 @@
+// Statistical comparison of two result sets, e.g., before and after a compiler, kernel or algorithm change:
+//
+//   g++ -std=c++17 -Wall -O3 tools/Compare.cc -o compare
+//   ./compare old-set new-set [ threshold=5 ] [ alpha=0.05 ] [ all ] [ strict ]
+//
+// A result set is a directory of harness output files, e.g., `hostname` as written by runall (searched recursively,
+// skipping executables), or a single file.  Files are matched by their path within the set, i.e., the algorithm with
+// its variant in the name (ZhangdT4) or directory (sweep/MCS), and results within a file by N (and by order for a
+// repeated N, e.g., the CPU pairs of runhandover).  A result is a harness result line, "N Time median avg std rstd%",
+// with the per-run totals of the following "totals:" line when the harness is compiled with -DTOTALS (as runall,
+// runsweep and runpartition do).
+//
+// For each matched result, the change is the relative difference of the median entries (higher is better).  With
+// per-run totals in both sets, the runs are compared with the two-sided Mann-Whitney U test (exact for up to 20 runs
+// per set without ties, otherwise the normal approximation with tie correction), and the effect size is Cliff's delta
+// (-1..1, the probability a new run beats an old run minus the reverse).  A result is a regression (improvement) when
+// its change is below -threshold (above threshold) percent and p < alpha.  Without totals no test is possible, and a
+// change beyond the threshold is reported as unverified, which does not fail unless strict is given, when an
+// unverified regression fails as a regression.  Only the results beyond the threshold are printed, or every matched
+// result with all.  The exit status is 1 when there is a regression, 2 on error, and otherwise 0, e.g., to gate an
+// upgrade.
+
+#include <algorithm>									// sort, min, max
+#include <cinttypes>									// strtoumax
+#include <cmath>										// erfc, sqrt, fabs
+#include <cstdio>
+#include <cstdlib>										// exit, strtod
+#include <cstring>										// strcmp, strncmp
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Result {
+	uint64_t median;
+	std::vector<double> runs;							// per-run totals, empty => none
+}; // Result
+
+typedef std::map<std::string, Result> Set;				// key: path within set, N and occurrence
+
+static void usage( const char *name ) {
+	fprintf( stderr, "Usage: %s old-set new-set (directory or file) [ threshold=percent (default 5) ] [ alpha=p (default 0.05) ] [ all ] [ strict ]\n", name );
+	exit( 2 );
+} // usage
+
+static bool resultLine( const std::string &line, int &n, uint64_t &median ) { // "N Time median avg std rstd%"
+	std::istringstream in( line );
+	std::vector<std::string> tokens;
+	for ( std::string t; in >> t; ) tokens.push_back( t );
+  if ( tokens.size() != 6 || tokens[5].back() != '%' ) return false;
+	char *end;
+	n = strtol( tokens[0].c_str(), &end, 10 );
+  if ( *end != '\0' || n < 1 ) return false;
+	strtol( tokens[1].c_str(), &end, 10 );
+  if ( *end != '\0' ) return false;
+	median = strtoumax( tokens[2].c_str(), &end, 10 );
+  if ( *end != '\0' ) return false;
+	for ( int i = 3; i < 5; i += 1 ) {
+		strtod( tokens[i].c_str(), &end );
+	  if ( *end != '\0' ) return false;
+	} // for
+	return true;
+} // resultLine
+
+static void readFile( const fs::path &file, const std::string &name, Set &set ) {
+	std::ifstream in( file );
+	std::map<int, int> occurrences;						// N => results seen
+	Result *last = nullptr;
+	for ( std::string line; std::getline( in, line ); ) {
+		int n = 0;
+		uint64_t median = 0;
+		if ( resultLine( line, n, median ) ) {
+			int occurrence = occurrences[n]++;
+			std::string key = name + ( name.empty() ? "N:" : " N:" ) + std::to_string( n ) + ( occurrence == 0 ? "" : "#" + std::to_string( occurrence + 1 ) );
+			last = &( set[key] = Result{ median, {} } );
+		} else if ( line.compare( 0, 7, "totals:" ) == 0 && last != nullptr && last->runs.empty() ) {
+			std::istringstream totals( line.substr( 7 ) );
+			for ( double t; totals >> t; ) last->runs.push_back( t );
+		} // if
+	} // for
+} // readFile
+
+static Set readSet( const char *path ) {
+	Set set;
+	fs::path root( path );
+	std::error_code ec;
+	if ( fs::is_regular_file( root, ec ) ) {
+		readFile( root, "", set );
+	} else if ( fs::is_directory( root, ec ) ) {
+		for ( const auto &entry : fs::recursive_directory_iterator( root, ec ) ) {
+		  if ( ! entry.is_regular_file() ) continue;
+		  if ( ( entry.status().permissions() & fs::perms::owner_exec ) != fs::perms::none ) continue; // executable
+			readFile( entry.path(), fs::relative( entry.path(), root ).generic_string(), set );
+		} // for
+	} else {
+		fprintf( stderr, "%s: no such file or directory\n", path );
+		exit( 2 );
+	} // if
+	return set;
+} // readSet
+
+static double exactP( size_t n1, size_t n2, double u ) {	// two-sided, no ties
+	std::vector<std::vector<double>> f( n2 + 1 );			// f[j][k]: orderings of i old and j new values with U = k
+	for ( size_t j = 0; j <= n2; j += 1 ) f[j].assign( n1 * n2 + 1, 0.0 ), f[j][0] = 1.0;
+	for ( size_t i = 1; i <= n1; i += 1 ) {
+		std::vector<std::vector<double>> g( n2 + 1, std::vector<double>( n1 * n2 + 1, 0.0 ) );
+		g[0][0] = 1.0;
+		for ( size_t j = 1; j <= n2; j += 1 )
+			for ( size_t k = 0; k <= i * j; k += 1 )	// largest value old (U unchanged) or new (U += i)
+				g[j][k] = f[j][k] + ( k >= i ? g[j - 1][k - i] : 0.0 );
+		f.swap( g );
+	} // for
+	double total = 0.0, lower = 0.0, upper = 0.0;
+	for ( size_t k = 0; k <= n1 * n2; k += 1 ) {
+		total += f[n2][k];
+		if ( k <= u ) lower += f[n2][k];
+		if ( k >= u ) upper += f[n2][k];
+	} // for
+	return std::min( 1.0, 2.0 * std::min( lower, upper ) / total );
+} // exactP
+
+static void mannWhitney( const std::vector<double> &x, const std::vector<double> &y, double &p, double &delta ) {
+	size_t n1 = x.size(), n2 = y.size(), greater = 0, less = 0;
+	for ( double a : x )
+		for ( double b : y ) {
+			greater += b > a;
+			less += b < a;
+		} // for
+	double u = greater + ( n1 * n2 - greater - less ) / 2.0;	// U of new sample, ties count half
+	delta = ( (double)greater - (double)less ) / ( n1 * n2 );
+
+	std::vector<double> all( x );						// tie correction
+	all.insert( all.end(), y.begin(), y.end() );
+	std::sort( all.begin(), all.end() );
+	double ties = 0.0;
+	for ( size_t i = 0, j; i < all.size(); i = j ) {
+		for ( j = i; j < all.size() && all[j] == all[i]; j += 1 );
+		double t = j - i;
+		ties += t * t * t - t;
+	} // for
+	if ( ties == 0.0 && n1 <= 20 && n2 <= 20 ) {
+		p = exactP( n1, n2, u );
+	} else {
+		double n = n1 + n2, mean = n1 * n2 / 2.0;
+		double sd = sqrt( n1 * n2 / 12.0 * ( ( n + 1 ) - ties / ( n * ( n - 1 ) ) ) );
+		p = sd == 0.0 ? 1.0 : std::min( 1.0, erfc( std::max( 0.0, fabs( u - mean ) - 0.5 ) / sd / sqrt( 2.0 ) ) );
+	} // if
+} // mannWhitney
+
+int main( int argc, char *argv[] ) {
+  if ( argc < 3 ) usage( argv[0] );
+	double threshold = 5.0, alpha = 0.05;
+	bool all = false, strict = false;
+	for ( int i = 3; i < argc; i += 1 ) {				// name=value arguments
+		if ( strncmp( argv[i], "threshold=", 10 ) == 0 ) threshold = strtod( argv[i] + 10, nullptr );
+		else if ( strncmp( argv[i], "alpha=", 6 ) == 0 ) alpha = strtod( argv[i] + 6, nullptr );
+		else if ( strcmp( argv[i], "all" ) == 0 ) all = true;
+		else if ( strcmp( argv[i], "strict" ) == 0 ) strict = true;
+		else usage( argv[0] );
+	} // for
+
+	Set olds = readSet( argv[1] ), news = readSet( argv[2] );
+	size_t matched = 0, tested = 0, regressions = 0, improvements = 0, unverified = 0, unverifiedRegressions = 0, onlyOld = 0;
+	for ( const auto &[key, o] : olds ) {
+		auto it = news.find( key );
+		if ( it == news.end() ) {
+			onlyOld += 1;
+			continue;
+		} // if
+		const Result &n = it->second;
+		matched += 1;
+		double change = o.median == 0 ? ( n.median == 0 ? 0.0 : INFINITY ) : ( (double)n.median - o.median ) * 100.0 / o.median;
+		bool beyond = fabs( change ) > threshold;
+		const char *verdict = "";
+		char stats[64] = "p:- delta:-";
+		if ( o.runs.size() >= 2 && n.runs.size() >= 2 ) {
+			double p, delta;
+			mannWhitney( o.runs, n.runs, p, delta );
+			snprintf( stats, sizeof(stats), "p:%.4f delta:%+.2f", p, delta );
+			tested += 1;
+			if ( beyond && p < alpha ) {
+				if ( change < 0 ) { verdict = "REGRESSION"; regressions += 1; }
+				else { verdict = "improvement"; improvements += 1; }
+			} // if
+		} else if ( beyond ) {
+			verdict = change < 0 ? "unverified-regression" : "unverified-improvement";
+			unverified += 1;
+			unverifiedRegressions += change < 0;
+		} // if
+	  if ( ! all && verdict[0] == '\0' ) continue;
+		printf( "compare %s old:%ju new:%ju change:%+.1f%% %s %s\n", key.c_str(), (uintmax_t)o.median, (uintmax_t)n.median,
+				change, stats, verdict );
+	} // for
+	size_t onlyNew = news.size() - matched;
+	printf( "compare threshold:%g%% alpha:%g matched:%zu tested:%zu regressions:%zu improvements:%zu unverified:%zu unmatched old:%zu new:%zu\n",
+			threshold, alpha, matched, tested, regressions, improvements, unverified, onlyOld, onlyNew );
+	if ( matched == 0 ) {
+		fprintf( stderr, "no matching results\n" );
+		return 2;
+	} // if
+	return regressions != 0 || ( strict && unverifiedRegressions != 0 );
+} // main
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-mode: "c++-mode" //
+// compile-command: "g++ -Wall -std=c++17 -O3 Compare.cc -o compare" //
+// End: //
@@ -0,0 +1,274 @@
+// Core-to-core communication latency matrix, the per-pair counterpart of Communicate.c (all threads writing one word):
+//
+//   g++ -std=c++17 -Wall -O3 tools/CoreMatrix.cc -o corematrix -lpthread
+//   ./corematrix [ cpus=0-7,64-71 (default process CPU set) ] [ rounds=R (default 1000) ] [ samples=S (default 7) ]
+//                [ gap=G (default 1.25) ] [ input=file ]
+//
+// For each pair of CPUs, two threads pinned to them bounce one cache line: the ping thread writes an odd value and
+// spins until the pong thread answers with the next even value.  A sample is the average round trip over R rounds,
+// after one warm-up sample, and the matrix prints the median of S samples in nanoseconds.
+//
+// The CPUs are then clustered: the pair latencies are sorted and split into tiers wherever a latency exceeds the one
+// below it by more than the factor G, and for each tier the clusters are the connected CPUs with latencies up to the
+// tier maximum (single linkage).  Each level prints its clusters and the Linux topology it coincides with, if any:
+// smt (thread siblings), l3 (shared last-level cache, e.g., an AMD CCX), socket (physical package) or node (memory
+// node).  These are the candidate boundaries for thread placement (Harness.c PIN) and for NUMA cohorts of lock
+// algorithms.  A matrix saved from the output is clustered again, e.g., with another G, with input=file.
+
+#include <algorithm>									// sort, unique, nth_element
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>										// exit, strtoul, strtod
+#include <cstring>										// strncmp
+#include <fstream>
+#include <map>
+#include <numeric>										// iota
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>										// sched_getaffinity, CPU_SET
+
+static inline void pause() {
+#if defined( __i386 ) || defined( __x86_64 )
+	__builtin_ia32_pause();
+#elif defined( __aarch64__ )
+	__asm__ __volatile__ ( "yield" );
+#endif
+} // pause
+
+struct alignas(128) Line {								// bounced cache line, 128 covers adjacent-line prefetch
+	std::atomic<uint64_t> value;
+}; // Line
+
+static void usage( const char *name ) {
+	fprintf( stderr, "Usage: %s [ cpus=list ] [ rounds=R (default 1000) ] [ samples=S (default 7) ] [ gap=G (default 1.25) ] [ input=file ]\n", name );
+	exit( EXIT_FAILURE );
+} // usage
+
+static std::vector<int> cpuList( const std::string &list ) { // "0-3,8" => 0 1 2 3 8
+	std::vector<int> cpus;
+	std::istringstream in( list );
+	for ( std::string range; std::getline( in, range, ',' ); ) {
+	  if ( range.empty() ) continue;
+		int lo, hi;
+		char dash;
+		std::istringstream r( range );
+		r >> lo;
+		if ( r >> dash >> hi ) for ( ; lo <= hi; lo += 1 ) cpus.push_back( lo );
+		else cpus.push_back( lo );
+	} // for
+	return cpus;
+} // cpuList
+
+static std::string rangeList( std::vector<int> cpus ) {	// 0 1 2 3 8 => "0-3,8"
+	std::sort( cpus.begin(), cpus.end() );
+	std::string s;
+	for ( size_t i = 0, j; i < cpus.size(); i = j ) {
+		for ( j = i + 1; j < cpus.size() && cpus[j] == cpus[j - 1] + 1; j += 1 );
+		s += ( s.empty() ? "" : "," ) + std::to_string( cpus[i] ) + ( j - i > 1 ? "-" + std::to_string( cpus[j - 1] ) : "" );
+	} // for
+	return s;
+} // rangeList
+
+static void pin( int cpu ) {
+	cpu_set_t mask;
+	CPU_ZERO( &mask );
+	CPU_SET( cpu, &mask );
+	int rc = pthread_setaffinity_np( pthread_self(), sizeof(mask), &mask );
+	if ( rc != 0 ) {
+		fprintf( stderr, "setaffinity CPU %d: %s\n", cpu, strerror( rc ) );
+		exit( EXIT_FAILURE );
+	} // if
+} // pin
+
+static double roundTrip( int a, int b, unsigned int rounds, unsigned int samples ) { // median nsec
+	static Line line;
+	std::atomic<int> ready( 0 );
+	const uint64_t total = (uint64_t)rounds * ( samples + 1 ); // + warm-up sample
+	line.value.store( 0, std::memory_order_relaxed );
+
+	std::thread pong( [&]() {
+		pin( b );
+		ready.fetch_add( 1 );
+		for ( uint64_t k = 0; k < total; k += 1 ) {
+			while ( line.value.load( std::memory_order_acquire ) != 2 * k + 1 ) pause();
+			line.value.store( 2 * k + 2, std::memory_order_release );
+		} // for
+	} );
+	std::vector<double> times;
+	std::thread ping( [&]() {
+		pin( a );
+		ready.fetch_add( 1 );
+		while ( ready.load() != 2 ) pause();
+		uint64_t k = 0;
+		for ( unsigned int s = 0; s <= samples; s += 1 ) {
+			auto start = std::chrono::steady_clock::now();
+			for ( unsigned int i = 0; i < rounds; i += 1, k += 1 ) {
+				line.value.store( 2 * k + 1, std::memory_order_release );
+				while ( line.value.load( std::memory_order_acquire ) != 2 * k + 2 ) pause();
+			} // for
+			double ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+			if ( s != 0 ) times.push_back( ns / rounds ); // skip warm-up
+		} // for
+	} );
+	ping.join();
+	pong.join();
+	std::nth_element( times.begin(), times.begin() + times.size() / 2, times.end() );
+	return times[times.size() / 2];
+} // roundTrip
+
+static std::string readLine( const std::string &path ) {
+	std::ifstream in( path );
+	std::string s;
+	std::getline( in, s );
+	return s;
+} // readLine
+
+static std::map<std::string, std::vector<std::string>> topology( const std::vector<int> &cpus ) { // name => key per CPU
+	std::map<std::string, std::vector<std::string>> keys;
+	for ( int cpu : cpus ) {
+		std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string( cpu );
+		keys["smt"].push_back( readLine( dir + "/topology/thread_siblings_list" ) );
+		keys["socket"].push_back( readLine( dir + "/topology/physical_package_id" ) );
+		std::string l3;
+		for ( int i = 0; i < 8; i += 1 ) {				// cache level 3
+			std::string index = dir + "/cache/index" + std::to_string( i );
+			if ( readLine( index + "/level" ) == "3" ) l3 = readLine( index + "/shared_cpu_list" );
+		} // for
+		keys["l3"].push_back( l3 );
+		std::string node;
+		for ( int n = 0; n < 64 && node.empty(); n += 1 )
+			if ( std::ifstream( dir + "/node" + std::to_string( n ) + "/cpulist" ) ) node = std::to_string( n );
+		keys["node"].push_back( node );
+	} // for
+	return keys;
+} // topology
+
+static int find( std::vector<int> &parent, int i ) {	// union-find root
+	while ( parent[i] != i ) i = parent[i] = parent[parent[i]];
+	return i;
+} // find
+
+int main( int argc, char *argv[] ) {
+	unsigned int rounds = 1000, samples = 7;
+	double gap = 1.25;
+	std::string cpuSpec, input;
+	for ( int i = 1; i < argc; i += 1 ) {				// name=value arguments
+		if ( strncmp( argv[i], "cpus=", 5 ) == 0 ) cpuSpec = argv[i] + 5;
+		else if ( strncmp( argv[i], "rounds=", 7 ) == 0 ) rounds = strtoul( argv[i] + 7, nullptr, 10 );
+		else if ( strncmp( argv[i], "samples=", 8 ) == 0 ) samples = strtoul( argv[i] + 8, nullptr, 10 );
+		else if ( strncmp( argv[i], "gap=", 4 ) == 0 ) gap = strtod( argv[i] + 4, nullptr );
+		else if ( strncmp( argv[i], "input=", 6 ) == 0 ) input = argv[i] + 6;
+		else usage( argv[0] );
+	} // for
+  if ( rounds == 0 || samples == 0 || gap <= 1.0 ) usage( argv[0] );
+
+	std::vector<int> cpus;
+	std::vector<std::vector<double>> lat;				// round trip, nsec
+	if ( input.empty() ) {
+		if ( cpuSpec.empty() ) {						// process CPU set
+			cpu_set_t mask;
+			sched_getaffinity( 0, sizeof(mask), &mask );
+			for ( int c = 0; c < CPU_SETSIZE; c += 1 ) if ( CPU_ISSET( c, &mask ) ) cpus.push_back( c );
+		} else {
+			cpus = cpuList( cpuSpec );
+			std::sort( cpus.begin(), cpus.end() );
+			cpus.erase( std::unique( cpus.begin(), cpus.end() ), cpus.end() );
+		} // if
+		size_t n = cpus.size();
+		lat.assign( n, std::vector<double>( n, 0.0 ) );
+		for ( size_t i = 0; i < n; i += 1 )
+			for ( size_t j = i + 1; j < n; j += 1 )
+				lat[i][j] = lat[j][i] = roundTrip( cpus[i], cpus[j], rounds, samples );
+	} else {											// matrix printed by an earlier run
+		std::ifstream in( input );
+		if ( ! in ) {
+			perror( input.c_str() );
+			exit( EXIT_FAILURE );
+		} // if
+		for ( std::string line; std::getline( in, line ); ) {
+			std::istringstream l( line );
+			std::string first;
+		  if ( ! ( l >> first ) || first == "matrix" || first == "cluster" ) continue;
+			if ( first == "cpu" ) {						// header
+				for ( int c; l >> c; ) cpus.push_back( c );
+				continue;
+			} // if
+			std::vector<double> row;
+			for ( std::string v; l >> v; ) row.push_back( v == "-" ? 0.0 : strtod( v.c_str(), nullptr ) );
+			if ( row.size() == cpus.size() ) lat.push_back( row );
+		} // for
+		if ( lat.size() != cpus.size() ) {
+			fprintf( stderr, "%s: not a core matrix\n", input.c_str() );
+			exit( EXIT_FAILURE );
+		} // if
+	} // if
+	const size_t n = cpus.size();
+
+	printf( "matrix cpus:%zu rounds:%u samples:%u round-trip nsec (median)\n", n, rounds, samples );
+	printf( "%5s", "cpu" );
+	for ( int c : cpus ) printf( " %6d", c );
+	printf( "\n" );
+	for ( size_t i = 0; i < n; i += 1 ) {
+		printf( "%5d", cpus[i] );
+		for ( size_t j = 0; j < n; j += 1 )
+			if ( i == j ) printf( " %6s", "-" );
+			else printf( " %6.1f", lat[i][j] );
+		printf( "\n" );
+	} // for
+  if ( n < 2 ) { printf( "cluster none, fewer than 2 CPUs\n" ); return 0; }
+
+	// tiers of pair latencies, split at gaps
+
+	struct Pair { double lat; size_t i, j; };
+	std::vector<Pair> pairs;
+	for ( size_t i = 0; i < n; i += 1 )
+		for ( size_t j = i + 1; j < n; j += 1 ) pairs.push_back( { lat[i][j], i, j } );
+	std::sort( pairs.begin(), pairs.end(), []( const Pair &a, const Pair &b ) { return a.lat < b.lat; } );
+
+	auto keys = input.empty() ? topology( cpus ) : std::map<std::string, std::vector<std::string>>();
+	std::vector<int> parent( n );
+	std::iota( parent.begin(), parent.end(), 0 );
+	unsigned int level = 0;
+	for ( size_t p = 0; p < pairs.size(); ) {
+		double lo = pairs[p].lat;
+		for ( ; p < pairs.size() && ( p == 0 || pairs[p].lat <= pairs[p - 1].lat * gap ); p += 1 ) { // join tier
+			int a = find( parent, pairs[p].i ), b = find( parent, pairs[p].j );
+			if ( a != b ) parent[a] = b;
+		} // for
+		double hi = pairs[p - 1].lat;
+		level += 1;
+
+		std::map<int, std::vector<int>> clusters;		// root => CPUs
+		std::vector<int> root( n );
+		for ( size_t i = 0; i < n; i += 1 ) clusters[root[i] = find( parent, i )].push_back( cpus[i] );
+		std::string matches;							// topology with same partition
+		for ( const auto &[name, key] : keys ) {
+			bool same = true;
+			for ( size_t i = 0; i < n && same; i += 1 )
+				for ( size_t j = i + 1; j < n && same; j += 1 )
+					same = ! key[i].empty() && ( root[i] == root[j] ) == ( key[i] == key[j] );
+			if ( same ) matches += ( matches.empty() ? "" : "," ) + name;
+		} // for
+		printf( "cluster level:%u nsec:%.1f-%.1f clusters:%zu topology:%s", level, lo, hi, clusters.size(),
+				matches.empty() ? ( input.empty() ? "-" : "unknown" ) : matches.c_str() );
+		for ( const auto &c : clusters ) printf( " {%s}", rangeList( c.second ).c_str() );
+		printf( "\n" );
+		if ( p < pairs.size() ) {						// start next tier
+			int a = find( parent, pairs[p].i ), b = find( parent, pairs[p].j );
+			if ( a != b ) parent[a] = b;
+			p += 1;
+		} // if
+	} // for
+	return 0;
+} // main
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-mode: "c++-mode" //
+// compile-command: "g++ -Wall -std=c++17 -O3 CoreMatrix.cc -o corematrix -lpthread" //
+// End: //
@@ -0,0 +1,268 @@
+// Timeline and ordering analysis of the lock ownership traces written by Harness.c -DTRACE, e.g.:
+//
+//   gcc -Wall -std=gnu11 -O3 -DNDEBUG -DTRACE -DAlgorithm=MCS Harness.c -lpthread -lm ; ./a.out 8 1
+//   g++ -std=c++17 -Wall -O3 tools/LockTrace.cc -o locktrace ; ./locktrace lock.trace [ json=lock.json ] [ run=r ] [ convoy=K ]
+//
+// The per-thread rings of one run (default the last) are merged and split into passages (arrive, doorway, enter, exit,
+// done).  When a ring wrapped, the merged trace starts at its oldest event, so every thread is traced from there.
+//
+// The timeline is written as Chrome/Perfetto trace JSON (open in ui.perfetto.dev or chrome://tracing): one track per
+// thread with its entry (and doorway), critical section and exit slices, and a lock track with the holder's id.
+//
+// The analysis orders a waiter from its doorway, or from its arrival when the algorithm does not mark DoorwayEnd():
+//   fcfs      FCFS violations: entries made while an earlier-ordered thread was waiting
+//   bypass    per passage, the entries by other threads between the thread's order point and its entry
+//   handover  contended handovers (the next holder waiting at the release): time from the previous holder's end of
+//             critical section to the next holder's start, which includes the exit protocol
+//   convoy    maximal runs of consecutive handovers with at least K threads waiting (default half the threads, at least
+//             2): number of episodes, their length in handovers and their share of the traced time
+
+#include <algorithm>									// sort, max
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>										// exit, strtoul
+#include <cstring>										// strcmp, strncmp
+#include <string>
+#include <vector>
+
+enum { TraceArrive, TraceDoorway, TraceEnter, TraceExit, TraceDone }; // as Harness.c
+
+struct TraceEvent {										// as Harness.c
+	uint64_t time;
+	uint32_t id;
+	uint16_t thread, cpu;
+	uint8_t event, run;
+}; // TraceEvent
+
+struct TraceHeader {									// as Harness.c
+	char magic[8];
+	char algorithm[32];
+	uint32_t threads, capacity;
+	uint32_t N, unused;
+	double tscPerNsec;
+}; // TraceHeader
+
+struct Passage {
+	unsigned int thread, id, cpu;
+	uint64_t arrive = 0, doorway = 0, enter = 0, exit = 0, done = 0; // 0 => not traced
+	uint64_t order() const { return doorway != 0 ? doorway : arrive; } // FCFS order point
+}; // Passage
+
+static void usage( const char *name ) {
+	fprintf( stderr, "Usage: %s trace-file [ json=file (default lock.json) ] [ run=r (default last) ] [ convoy=K ]\n", name );
+	exit( EXIT_FAILURE );
+} // usage
+
+static double percentile( std::vector<double> &v, double p ) { // v sorted
+	return v.empty() ? 0.0 : v[std::min( v.size() - 1, (size_t)( p * v.size() ) )];
+} // percentile
+
+int main( int argc, char *argv[] ) {
+  if ( argc < 2 ) usage( argv[0] );
+	std::string json = "lock.json";
+	int run = -1;
+	unsigned int convoy = 0;
+	for ( int i = 2; i < argc; i += 1 ) {				// name=value arguments
+		if ( strncmp( argv[i], "json=", 5 ) == 0 ) json = argv[i] + 5;
+		else if ( strncmp( argv[i], "run=", 4 ) == 0 ) run = strtoul( argv[i] + 4, nullptr, 10 );
+		else if ( strncmp( argv[i], "convoy=", 7 ) == 0 ) convoy = strtoul( argv[i] + 7, nullptr, 10 );
+		else usage( argv[0] );
+	} // for
+
+	FILE *trace = fopen( argv[1], "r" );
+	if ( trace == nullptr ) {
+		perror( argv[1] );
+		exit( EXIT_FAILURE );
+	} // if
+	TraceHeader h;
+	if ( fread( &h, sizeof(h), 1, trace ) != 1 || strncmp( h.magic, "LOCKTRCE", 8 ) != 0 ) {
+		fprintf( stderr, "%s: not a lock trace\n", argv[1] );
+		exit( EXIT_FAILURE );
+	} // if
+	h.algorithm[sizeof(h.algorithm) - 1] = '\0';
+	if ( convoy == 0 ) convoy = std::max( 2u, h.threads / 2 );
+
+	std::vector<uint64_t> counts( h.threads );
+	std::vector<std::vector<TraceEvent>> rings( h.threads );
+	if ( fread( counts.data(), sizeof(counts[0]), h.threads, trace ) != h.threads ) goto truncated;
+	for ( unsigned int t = 0; t < h.threads; t += 1 ) {
+		rings[t].resize( counts[t] );
+		if ( fread( rings[t].data(), sizeof(TraceEvent), counts[t], trace ) != counts[t] ) goto truncated;
+	} // for
+	fclose( trace );
+
+	{
+		if ( run == -1 )								// last traced run
+			for ( auto &r : rings ) if ( ! r.empty() ) run = std::max( run, (int)r.back().run );
+		uint64_t start = 0;								// all threads traced from start
+		for ( unsigned int t = 0; t < h.threads; t += 1 )
+			if ( counts[t] == h.capacity ) start = std::max( start, rings[t].front().time ); // wrapped ?
+
+		std::vector<Passage> passages;					// complete passages: entered and exited
+		std::vector<Passage> waits;						// passages with order point, for waiting analysis
+		for ( unsigned int t = 0; t < h.threads; t += 1 ) {
+			Passage p;
+			bool open = false;
+			for ( const TraceEvent &e : rings[t] ) {
+			  if ( e.run != run || e.time < start ) continue;
+				switch ( e.event ) {
+				  case TraceArrive:
+					p = Passage{ t, e.id, e.cpu };
+					p.arrive = e.time;
+					open = true;
+					break;
+				  case TraceDoorway:
+					if ( open ) p.doorway = e.time;
+					break;
+				  case TraceEnter:
+					if ( ! open ) p = Passage{ t, e.id, e.cpu }; // arrival not traced
+					p.id = e.id;
+					p.cpu = e.cpu;
+					p.enter = e.time;
+					open = true;
+					break;
+				  case TraceExit:
+					if ( open && p.enter != 0 ) p.exit = e.time;
+					break;
+				  case TraceDone:
+					if ( open && p.exit != 0 ) {
+						p.done = e.time;
+						passages.push_back( p );
+						if ( p.arrive != 0 ) waits.push_back( p );
+					} // if
+					open = false;
+					break;
+				} // switch
+			} // for
+		} // for
+		std::sort( passages.begin(), passages.end(), []( const Passage &a, const Passage &b ) { return a.enter < b.enter; } );
+	  if ( passages.empty() ) { printf( "trace algorithm:%s run:%d no passages\n", h.algorithm, run ); return 0; }
+
+		const uint64_t t0 = passages.front().arrive != 0 ? std::min( passages.front().arrive, passages.front().enter ) : passages.front().enter;
+		auto ns = [&h]( uint64_t d ) { return d / h.tscPerNsec; };
+		auto us = [&h, t0]( uint64_t t ) { return ( t - t0 ) / h.tscPerNsec / 1000.0; };
+
+		// Chrome/Perfetto trace JSON
+
+		FILE *out = fopen( json.c_str(), "w" );
+		if ( out == nullptr ) {
+			perror( json.c_str() );
+			exit( EXIT_FAILURE );
+		} // if
+		fprintf( out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n" );
+		fprintf( out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s threads\"}},\n", h.algorithm );
+		fprintf( out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"%s lock\"}},\n", h.algorithm );
+		fprintf( out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"holder\"}}" );
+		for ( unsigned int t = 0; t < h.threads; t += 1 )
+			fprintf( out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", t, t );
+		auto slice = [&]( const char *name, unsigned int pid, unsigned int tid, uint64_t b, uint64_t e, const Passage &p ) {
+			if ( b == 0 || e < b ) return;
+			fprintf( out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%u,\"cpu\":%u}}",
+					 name, pid, tid, us( b ), us( e ) - us( b ), p.id, p.cpu );
+		};
+		for ( const Passage &p : passages ) {
+			slice( "entry", 1, p.thread, p.arrive, p.enter, p );
+			slice( "doorway", 1, p.thread, p.arrive, p.doorway, p );
+			slice( "cs", 1, p.thread, p.enter, p.exit, p );
+			slice( "exit", 1, p.thread, p.exit, p.done, p );
+			char name[32];
+			snprintf( name, sizeof(name), "id %u", p.id );
+			slice( name, 2, 0, p.enter, p.exit, p );
+		} // for
+		fprintf( out, "\n]}\n" );
+		fclose( out );
+
+		// FCFS violations and bypasses: sweep entries, keeping the waiting passages
+
+		bool doorways = std::any_of( waits.begin(), waits.end(), []( const Passage &p ) { return p.doorway != 0; } );
+		struct Point { uint64_t time; int kind; size_t w; };	// kind 0 => start waiting, 1 => enter
+		std::vector<Point> points;
+		for ( size_t w = 0; w < waits.size(); w += 1 ) {
+			points.push_back( { waits[w].arrive, 0, w } );
+			points.push_back( { waits[w].enter, 1, w } );
+		} // for
+		std::sort( points.begin(), points.end(), []( const Point &a, const Point &b ) { return a.time < b.time || ( a.time == b.time && a.kind < b.kind ); } );
+		std::vector<size_t> waiting;					// waits index
+		std::vector<uint64_t> bypasses( waits.size(), 0 );
+		uint64_t violations = 0;
+		for ( const Point &pt : points ) {
+			if ( pt.kind == 0 ) {
+				waiting.push_back( pt.w );
+				continue;
+			} // if
+			const Passage &b = waits[pt.w];
+			for ( size_t w : waiting ) {
+			  if ( w == pt.w ) continue;
+				const Passage &a = waits[w];
+			  if ( a.order() >= b.enter ) continue;		// not yet ordered
+				bypasses[w] += 1;
+				if ( a.order() < b.order() ) violations += 1; // overtaken by later-ordered thread
+			} // for
+			waiting.erase( std::find( waiting.begin(), waiting.end(), pt.w ) );
+		} // for
+		uint64_t maxBypass = 0, sumBypass = 0;
+		for ( uint64_t b : bypasses ) { sumBypass += b; maxBypass = std::max( maxBypass, b ); }
+
+		// handovers and convoys: consecutive critical sections
+
+		std::vector<uint64_t> arrivals, entries;		// waiting at t: arrived before t and entered after t
+		for ( const Passage &w : waits ) {
+			arrivals.push_back( w.arrive );
+			entries.push_back( w.enter );
+		} // for
+		std::sort( arrivals.begin(), arrivals.end() );
+		std::sort( entries.begin(), entries.end() );
+		auto waitingAt = [&arrivals, &entries]( uint64_t t ) {
+			return (unsigned int)( ( std::lower_bound( arrivals.begin(), arrivals.end(), t ) - arrivals.begin() ) -
+								   ( std::upper_bound( entries.begin(), entries.end(), t ) - entries.begin() ) );
+		};
+		std::vector<double> gaps;
+		uint64_t uncontended = 0, episodes = 0, convoyLen = 0, maxConvoy = 0, convoyHandovers = 0, convoyTime = 0;
+		uint64_t convoyStart = 0;
+		for ( size_t k = 1; k <= passages.size(); k += 1 ) {
+			unsigned int waiters = 0;
+			if ( k < passages.size() ) {
+				const Passage &prev = passages[k - 1], &next = passages[k];
+				waiters = waitingAt( prev.exit );		// waiting at release
+				if ( next.arrive != 0 && next.arrive < prev.exit ) gaps.push_back( ns( next.enter - prev.exit ) );
+				else uncontended += 1;
+			} // if
+			if ( waiters >= convoy ) {					// convoy continues ?
+				if ( convoyLen == 0 ) convoyStart = passages[k - 1].exit;
+				convoyLen += 1;
+			} else if ( convoyLen != 0 ) {				// convoy ends
+				episodes += 1;
+				convoyHandovers += convoyLen;
+				maxConvoy = std::max( maxConvoy, convoyLen );
+				convoyTime += passages[k - 1].exit - convoyStart;
+				convoyLen = 0;
+			} // if
+		} // for
+		std::sort( gaps.begin(), gaps.end() );
+		double gapSum = 0.0;
+		for ( double g : gaps ) gapSum += g;
+		uint64_t span = passages.back().done - t0;
+
+		printf( "trace algorithm:%s N:%u threads:%u run:%d passages:%zu span:%.3fms json:%s\n", h.algorithm, h.N, h.threads,
+				run, passages.size(), ns( span ) / 1E6, json.c_str() );
+		printf( "trace fcfs order:%s violations:%ju (%.2f%% of entries)\n", doorways ? "doorway" : "arrival", violations,
+				waits.empty() ? 0.0 : 100.0 * violations / waits.size() );
+		printf( "trace bypass mean:%.2f max:%ju\n", waits.empty() ? 0.0 : (double)sumBypass / waits.size(), maxBypass );
+		printf( "trace handover contended:%zu uncontended:%ju mean:%.0fns p50:%.0fns p99:%.0fns max:%.0fns\n", gaps.size(),
+				uncontended, gaps.empty() ? 0.0 : gapSum / gaps.size(), percentile( gaps, 0.5 ), percentile( gaps, 0.99 ),
+				gaps.empty() ? 0.0 : gaps.back() );
+		printf( "trace convoy waiters>=%u episodes:%ju mean:%.1f max:%ju handovers time:%.2f%%\n", convoy, episodes,
+				episodes == 0 ? 0.0 : (double)convoyHandovers / episodes, maxConvoy, span == 0 ? 0.0 : 100.0 * convoyTime / span );
+	}
+	return 0;
+
+  truncated:
+	fprintf( stderr, "%s: truncated trace\n", argv[1] );
+	exit( EXIT_FAILURE );
+} // main
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-mode: "c++-mode" //
+// compile-command: "g++ -Wall -std=c++17 -O3 LockTrace.cc -o locktrace" //
+// End: //
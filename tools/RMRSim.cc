@@ -0,0 +1,225 @@
+// Offline remote-memory-reference (RMR) simulator for the traces written by Harness.c -DRMR, e.g.:
+//
+//   gcc -Wall -std=gnu11 -O3 -DNDEBUG -DRMR -DAlgorithm=MCS Harness.c -lpthread -lm ; ./a.out 8 1
+//   g++ -std=c++17 -Wall -O3 tools/RMRSim.cc -o rmrsim ; ./rmrsim rmr.trace [ cores=C ] [ line=B ] [ home=most|first ]
+//
+// The per-thread logs are merged by timestamp and replayed, each thread on its own core, or on core thread * C /
+// threads when cores=C is less than the traced threads, so threads on one core share its cache (SMT siblings or a
+// cluster).  An access is counted under two models:
+//   CC   cache-coherent MESI with a line of B bytes (default, the harness CACHE_ALIGN): a read is an RMR when the core's
+//        cache has the line invalid, and a write or atomic is an RMR unless the core has the line exclusive or
+//        modified, after which the other copies are invalid.  A read of a line no other cache holds loads it exclusive.
+//   DSM  distributed shared memory without coherent caches: each line lives in one core's memory, and every access by
+//        another core is an RMR.  The home of a line is the core accessing it most (home=most, the best static
+//        placement) or first (home=first, first touch).
+// A busy wait logged as a read and an RmrSpin record is replayed as two reads at its first and last poll, so a wait
+// counts at most two RMRs; a wait outlasting several remote writes to its line is undercounted.
+//
+// Each passage is split at the critical-section marks into entry (end of previous passage to critical section) and
+// exit (critical section to Passage); each thread's first passage is skipped, as its cache starts cold and the
+// constructor's initialization is not traced.  When a log filled, the merged trace is cut at the earliest last record
+// of a full log, so every thread is traced up to the cut.  The output is the average and maximum RMRs per passage for
+// each model and phase, and the fences and atomics per passage, e.g., for checking an O(1) (MCS) or O(log N) (RMRS,
+// ElevatorQueue) bound empirically as N grows, including N beyond the number of processors on the tracing machine.
+
+#include <algorithm>									// sort, min, max
+#include <cmath>										// log2
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>										// exit, strtoul
+#include <cstring>										// strcmp, strncmp
+#include <unordered_map>
+#include <vector>
+
+enum { RmrRead, RmrWrite, RmrAtomic, RmrFence, RmrEnter, RmrExit, RmrDone, RmrSpin }; // as Harness.c
+
+struct RmrRecord {										// as Harness.c
+	uint64_t time, addr;
+	uint32_t thread, kind;
+}; // RmrRecord
+
+struct RmrHeader {										// as Harness.c
+	char magic[8];
+	char algorithm[32];
+	uint32_t threads, capacity;
+	uint32_t N, line;
+}; // RmrHeader
+
+enum { CC, DSM, Models };
+enum { Entry, Exit, Phases };
+static const char *modelNames[] = { "CC", "DSM" };
+
+struct Line {											// MESI directory entry
+	int owner = -1;										// core with line exclusive or modified, -1 => none
+	std::vector<bool> sharers;							// cores with line shared
+}; // Line
+
+struct Passage {										// thread's current passage
+	int phase = Entry;									// Entry, in critical section (Phases) or Exit
+	bool warm = false;									// first passage done
+	uint64_t rmrs[Models][Phases] = {}, fences = 0, atomics = 0;
+}; // Passage
+
+struct Stats {
+	uint64_t passages = 0, fences = 0, atomics = 0;
+	uint64_t sum[Models][Phases + 1] = {}, max[Models][Phases + 1] = {}; // Phases => whole passage
+}; // Stats
+
+static void usage( const char *name ) {
+	fprintf( stderr, "Usage: %s trace-file [ cores=C (default traced threads) ] [ line=B (default trace) ] [ home=most|first ]\n", name );
+	exit( EXIT_FAILURE );
+} // usage
+
+int main( int argc, char *argv[] ) {
+  if ( argc < 2 ) usage( argv[0] );
+	unsigned int cores = 0, line = 0;
+	bool first = false;
+	for ( int i = 2; i < argc; i += 1 ) {				// name=value arguments
+		if ( strncmp( argv[i], "cores=", 6 ) == 0 ) cores = strtoul( argv[i] + 6, nullptr, 10 );
+		else if ( strncmp( argv[i], "line=", 5 ) == 0 ) line = strtoul( argv[i] + 5, nullptr, 10 );
+		else if ( strcmp( argv[i], "home=first" ) == 0 ) first = true;
+		else if ( strcmp( argv[i], "home=most" ) == 0 ) first = false;
+		else usage( argv[0] );
+	} // for
+
+	FILE *trace = fopen( argv[1], "r" );
+	if ( trace == nullptr ) {
+		perror( argv[1] );
+		exit( EXIT_FAILURE );
+	} // if
+	RmrHeader h;
+	if ( fread( &h, sizeof(h), 1, trace ) != 1 || strncmp( h.magic, "RMRTRACE", 8 ) != 0 ) {
+		fprintf( stderr, "%s: not an RMR trace\n", argv[1] );
+		exit( EXIT_FAILURE );
+	} // if
+	h.algorithm[sizeof(h.algorithm) - 1] = '\0';
+	if ( cores == 0 || cores > h.threads ) cores = h.threads;
+	if ( line == 0 ) line = h.line;
+	if ( cores == 0 || line == 0 || (line & (line - 1)) != 0 ) usage( argv[0] );
+
+	std::vector<uint64_t> counts( h.threads );
+	std::vector<RmrRecord> records;
+	uint64_t cut = UINT64_MAX, total = 0;
+	if ( fread( counts.data(), sizeof(counts[0]), h.threads, trace ) != h.threads ) goto truncated;
+	for ( unsigned int t = 0; t < h.threads; t += 1 ) {
+		size_t start = records.size();
+		records.resize( start + counts[t] );
+		if ( fread( &records[start], sizeof(RmrRecord), counts[t], trace ) != counts[t] ) goto truncated;
+		if ( counts[t] == h.capacity ) cut = std::min( cut, records.back().time ); // full log ?
+		total += counts[t];
+	} // for
+	fclose( trace );
+
+	records.erase( std::remove_if( records.begin(), records.end(), [cut]( const RmrRecord &r ) { return r.time > cut; } ), records.end() );
+	std::stable_sort( records.begin(), records.end(), []( const RmrRecord &a, const RmrRecord &b ) { return a.time < b.time; } );
+
+	{
+		auto coreOf = [&h, cores]( uint32_t thread ) { return (unsigned int)( (uint64_t)thread * cores / h.threads ); };
+		const unsigned int shift = __builtin_ctz( line );
+
+		std::unordered_map<uint64_t, int> home;			// DSM placement
+		if ( first ) {
+			for ( const RmrRecord &r : records )
+				if ( r.addr != 0 ) home.emplace( r.addr >> shift, coreOf( r.thread ) );
+		} else {
+			std::unordered_map<uint64_t, std::vector<uint64_t>> uses;
+			for ( const RmrRecord &r : records ) {
+			  if ( r.addr == 0 ) continue;
+				std::vector<uint64_t> &u = uses[r.addr >> shift];
+				if ( u.empty() ) u.resize( cores );
+				u[coreOf( r.thread )] += 1;
+			} // for
+			for ( auto &u : uses ) home[u.first] = std::max_element( u.second.begin(), u.second.end() ) - u.second.begin();
+		} // if
+
+		std::unordered_map<uint64_t, Line> lines;
+		std::vector<Passage> passages( h.threads );
+		Stats s;
+
+		for ( const RmrRecord &r : records ) {
+			Passage &p = passages[r.thread];
+			unsigned int core = coreOf( r.thread );
+			switch ( r.kind ) {
+			  case RmrEnter:
+				p.phase = Phases;							// critical section, not counted
+				continue;
+			  case RmrExit:
+				p.phase = Exit;
+				continue;
+			  case RmrDone:
+				if ( p.warm ) {
+					s.passages += 1;
+					s.fences += p.fences;
+					s.atomics += p.atomics;
+					for ( int m = 0; m < Models; m += 1 ) {
+						uint64_t whole = 0;
+						for ( int ph = 0; ph < Phases; ph += 1 ) {
+							s.sum[m][ph] += p.rmrs[m][ph];
+							s.max[m][ph] = std::max( s.max[m][ph], p.rmrs[m][ph] );
+							whole += p.rmrs[m][ph];
+						} // for
+						s.sum[m][Phases] += whole;
+						s.max[m][Phases] = std::max( s.max[m][Phases], whole );
+					} // for
+				} // if
+				p = Passage();
+				p.warm = true;
+				continue;
+			  case RmrFence:
+				if ( p.phase != Phases ) p.fences += 1;
+				continue;
+			} // switch
+
+			uint64_t l = r.addr >> shift;
+			Line &ln = lines[l];
+			if ( ln.sharers.empty() ) ln.sharers.resize( cores );
+			bool cc;										// coherence miss ?
+			if ( r.kind == RmrRead || r.kind == RmrSpin ) {
+				cc = ln.owner != (int)core && ! ln.sharers[core];
+				if ( cc ) {
+					bool shared = ln.owner != -1 || std::find( ln.sharers.begin(), ln.sharers.end(), true ) != ln.sharers.end();
+					if ( ln.owner != -1 ) {					// owner downgrades to shared
+						ln.sharers[ln.owner] = true;
+						ln.owner = -1;
+					} // if
+					if ( shared ) ln.sharers[core] = true;
+					else ln.owner = core;					// exclusive
+				} // if
+			} else {										// write or atomic
+				cc = ln.owner != (int)core;					// silent upgrade from exclusive
+				if ( cc ) {
+					std::fill( ln.sharers.begin(), ln.sharers.end(), false );
+					ln.owner = core;
+				} // if
+				if ( r.kind == RmrAtomic && p.phase != Phases ) p.atomics += 1;
+			} // if
+		  if ( p.phase == Phases ) continue;				// critical section
+			p.rmrs[CC][p.phase] += cc;
+			p.rmrs[DSM][p.phase] += home[l] != (int)core;
+		} // for
+
+		printf( "rmr algorithm:%s N:%u threads:%u cores:%u line:%u home:%s records:%zu/%ju passages:%ju lines:%zu log2N:%.1f\n",
+				h.algorithm, h.N, h.threads, cores, line, first ? "first" : "most", records.size(), total, s.passages,
+				lines.size(), log2( h.N ) );
+	  if ( s.passages == 0 ) return 0;
+		for ( int m = 0; m < Models; m += 1 ) {
+			printf( "rmr %-3s", modelNames[m] );
+			const char *phases[] = { "entry", "exit", "passage" };
+			for ( int ph = 0; ph <= Phases; ph += 1 )
+				printf( " %s:%.2f/%ju", phases[ph], (double)s.sum[m][ph] / s.passages, s.max[m][ph] );
+			printf( "\n" );
+		} // for
+		printf( "rmr fences:%.2f atomics:%.2f per passage\n", (double)s.fences / s.passages, (double)s.atomics / s.passages );
+	}
+	return 0;
+
+  truncated:
+	fprintf( stderr, "%s: truncated trace\n", argv[1] );
+	exit( EXIT_FAILURE );
+} // main
+
+// Local Variables: //
+// tab-width: 4 //
+// compile-mode: "c++-mode" //
+// compile-command: "g++ -Wall -std=c++17 -O3 RMRSim.cc -o rmrsim" //
+// End: //